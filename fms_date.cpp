@@ -2,6 +2,14 @@
 #ifdef _DEBUG
 #include <cassert>
 #include "fms_date.h"
+#include "fms_date_batch.h"
+#include "fms_date_calendar.h"
+#include "fms_date_calendar_file.h"
+#include "fms_date_excel.h"
+#include "fms_date_holiday.h"
+#include "fms_date_registry.h"
+#include "fms_date_schedule.h"
+#include "fms_date_text.h"
 
 using namespace fms::date;
 
@@ -9,6 +17,14 @@ int test_basic_date = fms::date::basic_date_test();
 int test_date_dcf = fms::date::dcf::test();
 int test_date = fms::date::test();
 int test_periodic = periodic_test();
+int test_batch = batch_test();
+int test_calendar = calendar_test();
+int test_calendar_file = calendar_file_test();
+int test_excel = excel_test();
+int test_holiday = holiday_test();
+int test_registry = registry_test();
+int test_schedule = schedule_test();
+int test_text = text_test();
 #endif // _DEBUG
 
 int main()
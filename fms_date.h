@@ -1,8 +1,14 @@
 // fms_date.h - Date and time calculation
 #pragma once
+#include <algorithm>
+#include <array>
 #include <chrono>
+#include <cstdint>
 #include <iterator>
+#include <limits>
+#include <ranges>
 #include <tuple>
+#include <utility>
 
 namespace fms::date {
 
@@ -36,6 +42,59 @@ namespace fms::date {
 		return years(sys_days(d0) - sys_days(d1));
 	}
 
+	// Days since 1970-01-01 in 32 bits.
+	// Convert from ymd once at ingest and do arithmetic on serial dates in hot paths.
+	// s1 - s0 is an exact duration in days that converts implicitly to years.
+	using serial = std::chrono::time_point<std::chrono::system_clock, std::chrono::duration<int32_t, std::chrono::days::period>>;
+
+	constexpr serial to_serial(const ymd& d)
+	{
+		return std::chrono::time_point_cast<serial::duration>(sys_days(d));
+	}
+	constexpr ymd to_ymd(const serial& s)
+	{
+		return ymd(sys_days(s));
+	}
+	constexpr serial make_serial(int y, unsigned int m, unsigned int d)
+	{
+		return to_serial(make_ymd(y, m, d));
+	}
+
+	// Precomputed serial date at the start of each month for years in [Y0, Y1].
+	// Dates outside the range fall back to <chrono>. There is no table to_ymd:
+	// searching the table is no faster than the <chrono> conversion.
+	template<int Y0 = 1900, int Y1 = 2200>
+	class month_table {
+		static constexpr int N = 12 * (Y1 - Y0 + 1);
+		std::array<int32_t, N + 1> start; // start[N] is the first day after the range
+	public:
+		constexpr month_table()
+			: start{}
+		{
+			for (int i = 0; i <= N; ++i) {
+				const auto d = ymd(std::chrono::year(Y0 + i / 12), std::chrono::month(i % 12 + 1), std::chrono::day(1));
+				start[i] = fms::date::to_serial(d).time_since_epoch().count();
+			}
+		}
+
+		constexpr bool contains(const ymd& d) const
+		{
+			return std::chrono::year(Y0) <= d.year() and d.year() <= std::chrono::year(Y1) and d.month().ok();
+		}
+
+		constexpr serial to_serial(const ymd& d) const
+		{
+			if (!contains(d)) {
+				return fms::date::to_serial(d);
+			}
+
+			const int i = 12 * ((int)d.year() - Y0) + (unsigned)d.month() - 1;
+
+			return serial(serial::duration(start[i] + (int)(unsigned)d.day() - 1));
+		}
+	};
+	inline constexpr month_table<> ymd_table;
+
 #ifdef _DEBUG
 	int basic_date_test()
 	{
@@ -61,6 +120,32 @@ namespace fms::date {
 			static_assert(sys_days(d1) + dd == sys_days(d0));
 			static_assert(sys_days(d0) - dd == sys_days(d1));
 		}
+		{
+			constexpr auto d0 = make_ymd(2023, 4, 5);
+			constexpr auto d1 = make_ymd(2024, 7, 6);
+			constexpr auto s0 = to_serial(d0);
+			constexpr auto s1 = make_serial(2024, 7, 6);
+			static_assert(sizeof(s0) == 4);
+			static_assert(to_ymd(s0) == d0);
+			static_assert(to_ymd(s1) == d1);
+			static_assert(years(s1 - s0) == d1 - d0);
+			static_assert(s0 + std::chrono::days(1) == make_serial(2023, 4, 6));
+			static_assert(to_serial(make_ymd(1970, 1, 1)).time_since_epoch().count() == 0);
+			static_assert(to_serial(make_ymd(1969, 12, 31)).time_since_epoch().count() == -1);
+		}
+		{
+			static_assert(ymd_table.to_serial(make_ymd(2023, 4, 5)) == make_serial(2023, 4, 5));
+			static_assert(ymd_table.to_serial(make_ymd(1900, 1, 1)) == make_serial(1900, 1, 1));
+			static_assert(ymd_table.to_serial(make_ymd(2200, 12, 31)) == make_serial(2200, 12, 31));
+			static_assert(ymd_table.to_serial(make_ymd(1899, 12, 31)) == make_serial(1899, 12, 31));
+			static_assert(ymd_table.to_serial(make_ymd(2023, 2, 30)) == make_serial(2023, 3, 2));
+
+			const auto s0 = make_serial(1900, 1, 1);
+			const auto s1 = make_serial(2201, 1, 1);
+			for (auto s = s0; s < s1; s += serial::duration(1)) {
+				assert(ymd_table.to_serial(to_ymd(s)) == s);
+			}
+		}
 
 		return 0;
 	}
@@ -70,14 +155,20 @@ namespace fms::date {
 	class periodic {
 		ymd effective, termination;
 		int months;
-		ymd current;
+		int count; // periods from current to termination, negative past the end
 	public:
 		// STL iterator
-		using iterator_category = std::forward_iterator_tag;
+		using iterator_concept = std::random_access_iterator_tag;
+		using iterator_category = std::random_access_iterator_tag;
 		using value_type = ymd;
+		using difference_type = std::ptrdiff_t;
+		using reference = ymd;
 
+		constexpr periodic()
+			: effective{}, termination{}, months{ 0 }, count{ -1 }
+		{ }
 		constexpr periodic(ymd effective, ymd termination, int months, bool end = false)
-			: effective{ effective }, termination{ termination }, months{ months }, current{ termination }
+			: effective{ effective }, termination{ termination }, months{ months }, count{ 0 }
 		{ 
 			if (end) {
 				operator++();
@@ -86,11 +177,20 @@ namespace fms::date {
 				reset();
 			}
 		}
+		// Civil calendar conversion happens once here.
+		constexpr periodic(serial effective, serial termination, int months)
+			: periodic(to_ymd(effective), to_ymd(termination), months)
+		{ }
 		constexpr periodic(const periodic&) = default;
 		constexpr periodic& operator=(const periodic&) = default;
 		constexpr ~periodic() = default;
 
 		constexpr bool operator==(const periodic&) const = default;
+		// Order of position in the same schedule.
+		constexpr auto operator<=>(const periodic& p) const
+		{
+			return p.count <=> count;
+		}
 
 		// order and direction of period are compatible
 		constexpr bool valid() const
@@ -106,35 +206,125 @@ namespace fms::date {
 		{
 			return periodic(effective, termination, months);
 		}
-		constexpr auto end() const
+		// Sentinel comparing equal to an iterator past termination.
+		constexpr std::default_sentinel_t end() const
+		{
+			return std::default_sentinel;
+		}
+		// Number of dates in the schedule.
+		constexpr std::size_t size() const
 		{
-			periodic(effective, termination, months, true);
+			return begin().count + 1;
 		}
 
 		constexpr explicit operator bool() const
 		{
-			return current <= termination;
+			return count >= 0;
 		}
 		constexpr value_type operator*() const
 		{
-			return current;
+			return termination - std::chrono::months(count * months);
+		}
+		// n-th date after the current date.
+		constexpr value_type operator[](difference_type n) const
+		{
+			return termination - std::chrono::months((count - n) * months);
 		}
 		constexpr periodic& operator++()
 		{
 			if (*this) {
-				current += std::chrono::months(months);
+				--count;
 			}
 
 			return *this;
 		}
+		constexpr periodic operator++(int)
+		{
+			auto p = *this;
+			operator++();
+
+			return p;
+		}
+		constexpr periodic& operator--()
+		{
+			++count;
+
+			return *this;
+		}
+		constexpr periodic operator--(int)
+		{
+			auto p = *this;
+			operator--();
+
+			return p;
+		}
+		constexpr periodic& operator+=(difference_type n)
+		{
+			count -= static_cast<int>(n);
+
+			return *this;
+		}
+		constexpr periodic& operator-=(difference_type n)
+		{
+			count += static_cast<int>(n);
+
+			return *this;
+		}
+		friend constexpr periodic operator+(periodic p, difference_type n)
+		{
+			return p += n;
+		}
+		friend constexpr periodic operator+(difference_type n, periodic p)
+		{
+			return p += n;
+		}
+		friend constexpr periodic operator-(periodic p, difference_type n)
+		{
+			return p -= n;
+		}
+		// Number of periods from q to p.
+		friend constexpr difference_type operator-(const periodic& p, const periodic& q)
+		{
+			return q.count - p.count;
+		}
+		friend constexpr bool operator==(const periodic& p, std::default_sentinel_t)
+		{
+			return !p;
+		}
+		// Number of dates remaining.
+		friend constexpr difference_type operator-(std::default_sentinel_t, const periodic& p)
+		{
+			return p.count + 1;
+		}
+		friend constexpr difference_type operator-(const periodic& p, std::default_sentinel_t)
+		{
+			return -(p.count + 1);
+		}
 	protected:
+		// Largest number of periods back from termination staying on or after effective.
+		// Computed from the month difference so the cost does not depend on the tenor.
 		constexpr void reset()
 		{
-			while (current - std::chrono::months(months) >= effective) {
-				current -= std::chrono::months(months);
+			if (months > 0) {
+				const auto [ey, em, ed] = from_ymd(effective);
+				const auto [ty, tm, td] = from_ymd(termination);
+				int dm = 12 * ((int)ty - (int)ey) + (int)(unsigned)tm - (int)(unsigned)em;
+				if (td < ed) {
+					--dm; // ymd compares day after month
+				}
+				count = dm / months;
 			}
 		}
 	};
+
+} // namespace fms::date
+
+// periodic is a lightweight view of its dates.
+template<>
+inline constexpr bool std::ranges::enable_view<fms::date::periodic> = true;
+
+namespace fms::date {
+
 #ifdef _DEBUG
 	static int periodic_test()
 	{
@@ -189,6 +379,78 @@ namespace fms::date {
 			++pi;
 			assert(!pi);
 		}
+		{
+			// agrees with stepping back one period at a time
+			[[maybe_unused]] const auto first = [](ymd eff, ymd ter, int months) {
+				auto current = ter;
+				while (current - std::chrono::months(months) >= eff) {
+					current -= std::chrono::months(months);
+				}
+				return current;
+			};
+			const auto e0 = make_serial(2020, 1, 1);
+			const auto t0 = make_serial(2021, 1, 25);
+			for ([[maybe_unused]] int months : {1, 3, 6, 12}) {
+				for (auto e = e0; e < e0 + serial::duration(400); e += serial::duration(1)) {
+					for (auto t = t0; t < t0 + serial::duration(100); t += serial::duration(1)) {
+						assert(*periodic(e, t, months) == first(to_ymd(e), to_ymd(t), months));
+					}
+				}
+			}
+			constexpr auto eff = make_ymd(1975, 3, 31);
+			constexpr auto ter = make_ymd(2025, 8, 31);
+			static_assert(*periodic(eff, ter, 1) == make_ymd(1975, 3, 31));
+			static_assert(*periodic(eff, ter, 6) == make_ymd(1975, 8, 31));
+			static_assert(*periodic(make_ymd(1975, 4, 1), ter, 1) == make_ymd(1975, 4, 31));
+		}
+		{
+			static_assert(std::random_access_iterator<periodic>);
+			constexpr auto eff = make_ymd(2023, 1, 15);
+			constexpr auto ter = make_ymd(2033, 1, 15);
+			constexpr auto p = periodic(eff, ter, 3);
+			static_assert(p.size() == 41);
+			static_assert(p.end() - p.begin() == 41);
+			static_assert(p[0] == eff);
+			static_assert(p[40] == ter);
+			static_assert(p[5] == *(p + 5));
+			static_assert(*(5 + p) == make_ymd(2024, 4, 15));
+			static_assert(*(p.begin() + 40) == ter);
+			static_assert(p < p + 1 and p + 1 > p and p <= p);
+			static_assert(!(p + 41));
+			static_assert((p + 40)[-40] == eff);
+
+			auto q = p;
+			q += 10;
+			assert(q - p == 10);
+			assert(*q-- == make_ymd(2025, 7, 15));
+			assert(*q == make_ymd(2025, 4, 15));
+			q -= 9;
+			assert(q == p);
+
+			// first coupon on or after a date
+			const auto i = std::ranges::lower_bound(p, make_ymd(2027, 3, 1));
+			assert(*i == make_ymd(2027, 4, 15));
+			assert(i - p.begin() == 17);
+		}
+		{
+			static_assert(std::ranges::view<periodic>);
+			static_assert(std::ranges::random_access_range<periodic>);
+			static_assert(std::ranges::sized_range<periodic>);
+			constexpr auto p = periodic(make_ymd(2023, 4, 30), make_ymd(2024, 9, 30), 6);
+			static_assert(std::ranges::distance(p) == 3);
+			static_assert(std::ranges::size(p) == 3);
+
+			int n = 0;
+			for ([[maybe_unused]] auto d : p) {
+				assert(d == p[n]);
+				++n;
+			}
+			assert(n == 3);
+
+			auto q = p | std::views::transform([](const ymd& d) { return to_serial(d); });
+			static_assert(std::ranges::view<decltype(q)>);
+			assert(q[1] == make_serial(2024, 3, 30));
+		}
 
 		return 0;
 	}
@@ -197,6 +459,14 @@ namespace fms::date {
 	// Day count fraction appoximately equal to time in year between dates.
 	// https://eagledocs.atlassian.net/wiki/spaces/Accounting2017/pages/439484565/Understand+Day+Count+Basis+Options
 	using dcf_ = years(*)(const ymd&, const ymd&);
+	// Day count conventions named after the dcf functions.
+	enum class day_count {
+		_years,
+		_30_360,
+		_30E_360,
+		_actual_360,
+		_actual_365,
+	};
 	namespace dcf {
 		// Day count fraction in years from d0 to d1.
 		constexpr years _years(const ymd& d0, const ymd& d1)
@@ -246,6 +516,94 @@ namespace fms::date {
 			return years((sys_days(t1) - sys_days(t0)).count() / 365.);
 		}
 
+		// Serial date overloads. Actual conventions need no civil calendar conversion.
+		constexpr years _years(const serial& d0, const serial& d1)
+		{
+			return d1 - d0;
+		}
+		constexpr years _30_360(const serial& t0, const serial& t1)
+		{
+			return _30_360(to_ymd(t0), to_ymd(t1));
+		}
+		constexpr years _30E_360(const serial& t0, const serial& t1)
+		{
+			return _30E_360(to_ymd(t0), to_ymd(t1));
+		}
+		constexpr years _actual_360(const serial& t0, const serial& t1)
+		{
+			return years((t1 - t0).count() / 360.);
+		}
+		constexpr years _actual_365(const serial& t0, const serial& t1)
+		{
+			return years((t1 - t0).count() / 365.);
+		}
+
+		// Day count fraction with the convention fixed at compile time so the kernel inlines.
+		// T is ymd or serial.
+		template<day_count DC, class T>
+		constexpr years year_fraction(const T& t0, const T& t1)
+		{
+			if constexpr (DC == day_count::_years) {
+				return _years(t0, t1);
+			}
+			else if constexpr (DC == day_count::_30_360) {
+				return _30_360(t0, t1);
+			}
+			else if constexpr (DC == day_count::_30E_360) {
+				return _30E_360(t0, t1);
+			}
+			else if constexpr (DC == day_count::_actual_360) {
+				return _actual_360(t0, t1);
+			}
+			else if constexpr (DC == day_count::_actual_365) {
+				return _actual_365(t0, t1);
+			}
+			else {
+				static_assert(DC != DC, "unknown day count");
+			}
+		}
+
+		// Day count fraction with the convention chosen at run time.
+		// Hoist this out of loops over periods by switching on the convention
+		// once and calling year_fraction<DC> in each case.
+		template<class T>
+		constexpr years year_fraction(day_count dc, const T& t0, const T& t1)
+		{
+			switch (dc) {
+			case day_count::_years:
+				return year_fraction<day_count::_years>(t0, t1);
+			case day_count::_30_360:
+				return year_fraction<day_count::_30_360>(t0, t1);
+			case day_count::_30E_360:
+				return year_fraction<day_count::_30E_360>(t0, t1);
+			case day_count::_actual_360:
+				return year_fraction<day_count::_actual_360>(t0, t1);
+			case day_count::_actual_365:
+				return year_fraction<day_count::_actual_365>(t0, t1);
+			default:
+				return years(std::numeric_limits<double>::quiet_NaN());
+			}
+		}
+
+		// Compatibility shim for code using dcf_ function pointers.
+		constexpr dcf_ function(day_count dc)
+		{
+			switch (dc) {
+			case day_count::_years:
+				return _years;
+			case day_count::_30_360:
+				return _30_360;
+			case day_count::_30E_360:
+				return _30E_360;
+			case day_count::_actual_360:
+				return _actual_360;
+			case day_count::_actual_365:
+				return _actual_365;
+			default:
+				return nullptr;
+			}
+		}
+
 #ifdef _DEBUG
 #define DATE_DCF_TEST(X) \
 	X(make_ymd(2003, 12, 29), make_ymd(2004, 1, 31), 31, 32, 33) \
@@ -292,6 +650,19 @@ namespace fms::date {
 				constexpr auto yy = years(dd.count() / 365.);
 				static_assert(y3 == yy);
 			}
+			{
+				constexpr auto t0 = year(2003) / 12 / 31;
+				constexpr auto t1 = year(2004) / 2 / 1;
+				static_assert(year_fraction<day_count::_30_360>(t0, t1) == _30_360(t0, t1));
+				static_assert(year_fraction<day_count::_30E_360>(to_serial(t0), to_serial(t1)) == _30E_360(t0, t1));
+				static_assert(year_fraction(day_count::_actual_360, t0, t1) == _actual_360(t0, t1));
+				static_assert(year_fraction(day_count::_actual_365, to_serial(t0), to_serial(t1)) == _actual_365(t0, t1));
+				static_assert(year_fraction(day_count::_years, t0, t1) == _years(t0, t1));
+				static_assert(year_fraction((day_count)-1, t0, t1) != year_fraction((day_count)-1, t0, t1));
+				static_assert(function(day_count::_30_360)(t0, t1) == _30_360(t0, t1));
+				static_assert(function(day_count::_actual_365) == static_cast<dcf_>(_actual_365));
+				static_assert(function((day_count)-1) == nullptr);
+			}
 
 			return 0;
 		}
@@ -326,19 +697,51 @@ namespace fms::date {
 	using calendar = bool(*)(const ymd&);
 	namespace calendars {
 
-		constexpr bool weekday(const ymd& d)
+		// Weekend days as a 7 bit mask indexed by weekday::c_encoding(), Sunday is bit 0.
+		struct weekend {
+			unsigned mask;
+
+			constexpr bool operator()(const ymd& d) const
+			{
+				return (mask >> std::chrono::weekday(sys_days(d)).c_encoding()) & 1;
+			}
+			// Calendar function with the same weekend.
+			constexpr operator calendar() const;
+		};
+		inline constexpr weekend saturday_sunday{ 0b1000001 };
+		inline constexpr weekend friday_saturday{ 0b1100000 };
+		inline constexpr weekend thursday_friday{ 0b0110000 };
+		inline constexpr weekend friday{ 0b0100000 };
+		inline constexpr weekend sunday{ 0b0000001 };
+
+		template<unsigned Mask>
+		constexpr bool weekend_days(const ymd& d)
 		{
-				auto w = std::chrono::year_month_weekday(d);
-				auto wd = w.weekday();
+			return weekend{ Mask }(d);
+		}
+		template<size_t... I>
+		constexpr std::array<calendar, sizeof...(I)> make_weekends(std::index_sequence<I...>)
+		{
+			return { weekend_days<I>... };
+		}
+		// Calendar function for every weekend mask.
+		inline constexpr auto weekends = make_weekends(std::make_index_sequence<128>{});
 
-				return (wd == std::chrono::Saturday) or (wd == std::chrono::Sunday);
+		constexpr weekend::operator calendar() const
+		{
+			return weekends[mask & 127];
+		}
+
+		constexpr bool weekday(const ymd& d)
+		{
+			return saturday_sunday(d);
 		}
 		constexpr bool example(const ymd& d)
 		{
 			return weekday(d) or holidays::new_year_day(d);
 		}
 
-		// constexpr bool nyse(const ymd& d) ...
+		// See fms_date_holiday.h for exchange calendars.
 
 	} // namespace calendars
 
@@ -351,38 +754,68 @@ namespace fms::date {
 		modified_previous,  // previous business day unless different month
 	};
 
-	constexpr ymd adjust(const ymd& date, roll convention, const calendar& cal = calendars::weekday)
+	// Adjust serial date stepping in days. The calendar still takes ymd.
+	constexpr serial adjust(const serial& date, roll convention, const calendar& cal = calendars::weekday)
 	{
-		if (!cal(date)) {
+		if (!cal(to_ymd(date))) {
 			return date;
 		}
 
+		const auto following = [&cal](serial s) {
+			do {
+				s += serial::duration(1);
+			} while (cal(to_ymd(s)));
+			return s;
+		};
+		const auto previous = [&cal](serial s) {
+			do {
+				s -= serial::duration(1);
+			} while (cal(to_ymd(s)));
+			return s;
+		};
+
 		switch (convention) {
 		case roll::none:
 			return date;
 		case roll::previous:
-			return adjust(sys_days(date) - std::chrono::days(1), convention, cal);
+			return previous(date);
 		case roll::following:
-			return adjust(sys_days(date) + std::chrono::days(1), convention, cal);
+			return following(date);
 		case roll::modified_following:
 		{
-			const auto date_ = adjust(sys_days(date), roll::following, cal);
-			return date_.month() == date.month()
+			const auto date_ = following(date);
+			return to_ymd(date_).month() == to_ymd(date).month()
 				? date_
-				: adjust(date, roll::previous, cal);
+				: previous(date);
 		}
 		case roll::modified_previous:
 		{
-			const auto date_ = adjust(sys_days(date), roll::previous, cal);
-			return date_.month() == date.month()
+			const auto date_ = previous(date);
+			return to_ymd(date_).month() == to_ymd(date).month()
 				? date_
-				: adjust(date, roll::following, cal);
+				: following(date);
 		}
 		default:
-			return ymd{};
+			return serial{};
 		}
+	}
 
-		return date;
+	constexpr ymd adjust(const ymd& date, roll convention, const calendar& cal = calendars::weekday)
+	{
+		if (!cal(date)) {
+			return date;
+		}
+
+		switch (convention) {
+		case roll::none:
+		case roll::previous:
+		case roll::following:
+		case roll::modified_following:
+		case roll::modified_previous:
+			return to_ymd(adjust(to_serial(date), convention, cal));
+		default:
+			return ymd{};
+		}
 	}
 
 	enum class frequency {
@@ -412,6 +845,35 @@ namespace fms::date {
 			constexpr auto y0 = dcf::_years(d0, d1);
 			static_assert(dy == y0);
 		}
+		{
+			constexpr auto d0 = make_ymd(2023, 9, 30); // Saturday
+			constexpr auto s0 = to_serial(d0);
+			static_assert(adjust(s0, roll::none) == s0);
+			static_assert(adjust(s0, roll::following) == make_serial(2023, 10, 2));
+			static_assert(adjust(s0, roll::previous) == make_serial(2023, 9, 29));
+			static_assert(adjust(s0, roll::modified_following) == make_serial(2023, 9, 29));
+			static_assert(to_serial(adjust(d0, roll::modified_following)) == adjust(s0, roll::modified_following));
+			static_assert(adjust(make_serial(2023, 10, 1), roll::modified_previous) == make_serial(2023, 10, 2));
+			static_assert(adjust(s0, roll::following, calendars::friday_saturday) == make_serial(2023, 10, 1));
+			static_assert(calendars::friday_saturday(make_ymd(2023, 9, 29)) and !calendars::friday_saturday(make_ymd(2023, 10, 1)));
+			static_assert(calendars::weekday(make_ymd(2023, 10, 1)) and !calendars::weekday(make_ymd(2023, 9, 29)));
+
+			constexpr auto s1 = make_serial(2024, 1, 31);
+			static_assert(dcf::_years(s0, s1) == dcf::_years(d0, to_ymd(s1)));
+			static_assert(dcf::_30_360(s0, s1) == dcf::_30_360(d0, to_ymd(s1)));
+			static_assert(dcf::_30E_360(s0, s1) == dcf::_30E_360(d0, to_ymd(s1)));
+			static_assert(dcf::_actual_360(s0, s1) == dcf::_actual_360(d0, to_ymd(s1)));
+			static_assert(dcf::_actual_365(s0, s1) == dcf::_actual_365(d0, to_ymd(s1)));
+
+			constexpr auto p = periodic(s0, s1, 3);
+			static_assert(*p == make_ymd(2023, 10, 31));
+		}
+		{
+			// adjusted schedule without intermediate storage
+			constexpr auto p = periodic(make_ymd(2023, 4, 30), make_ymd(2024, 9, 30), 6);
+			[[maybe_unused]] auto q = p | std::views::transform([](const ymd& d) { return adjust(d, roll::following); });
+			assert(std::ranges::equal(q, std::array{ make_ymd(2023, 10, 2), make_ymd(2024, 4, 1), make_ymd(2024, 9, 30) }));
+		}
 
 		return 0;
 	}
@@ -0,0 +1,472 @@
+// fms_date_batch.h - Conversions over arrays of dates
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <span>
+#include <type_traits>
+#include <vector>
+#include "fms_date.h"
+
+namespace fms::date {
+
+	// Branch free days since 1970-01-01 from year, month, and day.
+	// Neri and Schneider, Euclidean affine functions and their application to calendar algorithms.
+	// https://arxiv.org/abs/2102.06959
+	constexpr int32_t days_from_civil(int y, unsigned m, unsigned d)
+	{
+		constexpr uint32_t z2 = static_cast<uint32_t>(-1468000);
+		constexpr uint32_t r2_e3 = 536895458;
+
+		const uint32_t y1 = static_cast<uint32_t>(y) - z2;
+		const uint32_t j = m < 3;
+		const uint32_t y0 = y1 - j;
+		const uint32_t m0 = j ? m + 12 : m;
+		const uint32_t q1 = y0 / 100;
+		const uint32_t yc = 1461 * y0 / 4 - q1 + q1 / 4;
+		const uint32_t mc = (979 * m0 - 2919) / 32;
+
+		return static_cast<int32_t>(yc + mc + d - 1 - r2_e3);
+	}
+	constexpr int32_t days_from_civil(const ymd& d)
+	{
+		const auto [y, m, d_] = from_ymd(d);
+
+		return days_from_civil((int)y, (unsigned)m, (unsigned)d_);
+	}
+
+	// Branch free inverse of days_from_civil.
+	constexpr void civil_from_days(int32_t n, int32_t& y, uint32_t& m, uint32_t& d)
+	{
+		constexpr uint32_t z2 = static_cast<uint32_t>(-1468000);
+		constexpr uint32_t r2_e3 = 536895458;
+
+		const uint32_t r0 = static_cast<uint32_t>(n) + r2_e3;
+		const uint32_t n1 = 4 * r0 + 3;
+		const uint32_t q1 = n1 / 146097;
+		const uint32_t r1 = n1 % 146097 / 4;
+
+		const uint32_t n2 = 4 * r1 + 3;
+		const uint64_t u2 = static_cast<uint64_t>(2939745) * n2;
+		const uint32_t q2 = static_cast<uint32_t>(u2 >> 32);
+		const uint32_t r2 = static_cast<uint32_t>(u2) / 2939745 / 4;
+
+		const uint32_t n3 = 2141 * r2 + 197913;
+		const uint32_t q3 = n3 >> 16;
+		const uint32_t r3 = (n3 & 0xFFFF) / 2141;
+
+		const uint32_t j = r2 >= 306;
+		y = static_cast<int32_t>(100 * q1 + q2 + j + z2);
+		m = j ? q3 - 12 : q3;
+		d = r3 + 1;
+	}
+	constexpr ymd civil_from_days(int32_t n)
+	{
+		int32_t y;
+		uint32_t m, d;
+		civil_from_days(n, y, m, d);
+
+		return make_ymd(y, m, d);
+	}
+
+	// Dates are converted in blocks of fields held in local arrays so the
+	// kernel vectorizes without aliasing the packed ymd bytes.
+	constexpr size_t batch_block = 64;
+
+	// ymd is 16 bit year, 8 bit month, and 8 bit day in a little endian word,
+	// as in libstdc++, libc++, and the Microsoft STL.
+	constexpr bool ymd_packed = sizeof(ymd) == sizeof(uint32_t)
+		and std::bit_cast<uint32_t>(make_ymd(-2, 3, 4)) == (0xFFFEu | 3u << 16 | 4u << 24);
+
+	namespace kernel {
+
+		// Bodies are forced inline so an instruction set target of the caller
+		// applies to the whole loop.
+#if defined(__GNUC__)
+#define FMS_DATE_FORCE_INLINE __attribute__((always_inline)) inline
+#elif defined(_MSC_VER)
+#define FMS_DATE_FORCE_INLINE __forceinline
+#else
+#define FMS_DATE_FORCE_INLINE inline
+#endif
+
+		// Year, month, and day fields of k <= batch_block dates.
+		FMS_DATE_FORCE_INLINE void fields_n(const ymd* d, size_t k, int32_t* y, uint32_t* m, uint32_t* d_)
+		{
+			if constexpr (ymd_packed) {
+				uint32_t p[batch_block];
+				std::memcpy(p, d, k * sizeof(ymd));
+				for (size_t j = 0; j < k; ++j) {
+					y[j] = (int16_t)p[j];
+					m[j] = (p[j] >> 16) & 0xFF;
+					d_[j] = p[j] >> 24;
+				}
+			}
+			else {
+				for (size_t j = 0; j < k; ++j) {
+					y[j] = (int)d[j].year();
+					m[j] = (unsigned)d[j].month();
+					d_[j] = (unsigned)d[j].day();
+				}
+			}
+		}
+		FMS_DATE_FORCE_INLINE void fields_n(const serial* s, size_t k, int32_t* y, uint32_t* m, uint32_t* d_)
+		{
+			for (size_t j = 0; j < k; ++j) {
+				civil_from_days(s[j].time_since_epoch().count(), y[j], m[j], d_[j]);
+			}
+		}
+
+		template<class S>
+		FMS_DATE_FORCE_INLINE void to_serial_n(const ymd* d, size_t n, S* s)
+		{
+			int32_t y[batch_block];
+			uint32_t m[batch_block], d_[batch_block];
+
+			for (size_t i = 0; i < n; i += batch_block) {
+				const size_t k = std::min(batch_block, n - i);
+				fields_n(d + i, k, y, m, d_);
+				for (size_t j = 0; j < k; ++j) {
+					if constexpr (std::is_same_v<S, serial>) {
+						s[i + j] = serial(serial::duration(days_from_civil(y[j], m[j], d_[j])));
+					}
+					else {
+						s[i + j] = days_from_civil(y[j], m[j], d_[j]);
+					}
+				}
+			}
+		}
+
+		template<class S>
+		FMS_DATE_FORCE_INLINE void to_ymd_n(const S* s, size_t n, ymd* d)
+		{
+			int32_t y[batch_block];
+			uint32_t m[batch_block], d_[batch_block], p[batch_block];
+
+			for (size_t i = 0; i < n; i += batch_block) {
+				const size_t k = std::min(batch_block, n - i);
+				for (size_t j = 0; j < k; ++j) {
+					if constexpr (std::is_same_v<S, serial>) {
+						civil_from_days(s[i + j].time_since_epoch().count(), y[j], m[j], d_[j]);
+					}
+					else {
+						civil_from_days(s[i + j], y[j], m[j], d_[j]);
+					}
+				}
+				if constexpr (ymd_packed) {
+					for (size_t j = 0; j < k; ++j) {
+						p[j] = (uint16_t)y[j] | m[j] << 16 | d_[j] << 24;
+					}
+					std::memcpy(d + i, p, k * sizeof(ymd));
+				}
+				else {
+					for (size_t j = 0; j < k; ++j) {
+						d[i + j] = make_ymd(y[j], m[j], d_[j]);
+					}
+				}
+			}
+		}
+
+		// 30/360 year fractions of n date pairs. European if E is true.
+		template<bool E, class T>
+		FMS_DATE_FORCE_INLINE void _30_360_n(const T* t0, const T* t1, size_t n, double* out)
+		{
+			int32_t y0[batch_block], y1[batch_block];
+			uint32_t m0[batch_block], m1[batch_block], d0[batch_block], d1[batch_block];
+
+			for (size_t i = 0; i < n; i += batch_block) {
+				const size_t k = std::min(batch_block, n - i);
+				fields_n(t0 + i, k, y0, m0, d0);
+				fields_n(t1 + i, k, y1, m1, d1);
+				// day adjustments are selects, not branches
+				for (size_t j = 0; j < k; ++j) {
+					const int32_t d0_ = d0[j] == 31 ? 30 : d0[j];
+					int32_t d1_;
+					if constexpr (E) {
+						d1_ = d1[j] == 31 ? 30 : d1[j];
+					}
+					else {
+						d1_ = (d1[j] == 31 and d0_ > 29) ? 30 : d1[j];
+					}
+					const int32_t dy = y1[j] - y0[j];
+					const int32_t dm = (int32_t)m1[j] - (int32_t)m0[j];
+
+					out[i + j] = (360 * dy + 30 * dm + d1_ - d0_) / 360.;
+				}
+			}
+		}
+
+#undef FMS_DATE_FORCE_INLINE
+
+		// AVX2 copies of the kernels chosen at run time on x86 with GCC or Clang.
+		// Other compilers, such as MSVC, have no per function target and use the
+		// portable kernels built for the instruction set of the translation unit.
+#if defined(__GNUC__) and (defined(__x86_64__) or defined(__i386__))
+#define FMS_DATE_AVX2
+		template<class S>
+		__attribute__((target("avx2"))) void to_serial_n_avx2(const ymd* d, size_t n, S* s)
+		{
+			to_serial_n(d, n, s);
+		}
+		template<class S>
+		__attribute__((target("avx2"))) void to_ymd_n_avx2(const S* s, size_t n, ymd* d)
+		{
+			to_ymd_n(s, n, d);
+		}
+		template<bool E, class T>
+		__attribute__((target("avx2"))) void _30_360_n_avx2(const T* t0, const T* t1, size_t n, double* out)
+		{
+			_30_360_n<E>(t0, t1, n, out);
+		}
+		inline bool avx2()
+		{
+			static const bool b = __builtin_cpu_supports("avx2");
+
+			return b;
+		}
+#endif
+
+	} // namespace kernel
+
+	// Convert n dates to days since 1970-01-01. S is int32_t or serial.
+	template<class S>
+	inline void to_serial_n(const ymd* d, size_t n, S* s)
+	{
+#ifdef FMS_DATE_AVX2
+		if (kernel::avx2()) {
+			return kernel::to_serial_n_avx2(d, n, s);
+		}
+#endif
+		kernel::to_serial_n(d, n, s);
+	}
+
+	// Convert n days since 1970-01-01 to dates. S is int32_t or serial.
+	template<class S>
+	inline void to_ymd_n(const S* s, size_t n, ymd* d)
+	{
+#ifdef FMS_DATE_AVX2
+		if (kernel::avx2()) {
+			return kernel::to_ymd_n_avx2(s, n, d);
+		}
+#endif
+		kernel::to_ymd_n(s, n, d);
+	}
+
+	// Convert dates to days since 1970-01-01. Return the number of dates converted.
+	inline size_t to_serial(std::span<const ymd> d, std::span<int32_t> s)
+	{
+		const size_t n = std::min(d.size(), s.size());
+		to_serial_n(d.data(), n, s.data());
+
+		return n;
+	}
+	inline size_t to_serial(std::span<const ymd> d, std::span<serial> s)
+	{
+		const size_t n = std::min(d.size(), s.size());
+		to_serial_n(d.data(), n, s.data());
+
+		return n;
+	}
+
+	// Convert days since 1970-01-01 to dates. Return the number of dates converted.
+	inline size_t to_ymd(std::span<const int32_t> s, std::span<ymd> d)
+	{
+		const size_t n = std::min(s.size(), d.size());
+		to_ymd_n(s.data(), n, d.data());
+
+		return n;
+	}
+	inline size_t to_ymd(std::span<const serial> s, std::span<ymd> d)
+	{
+		const size_t n = std::min(s.size(), d.size());
+		to_ymd_n(s.data(), n, d.data());
+
+		return n;
+	}
+
+	namespace dcf {
+
+		// Days since 1970-01-01 of a serial date or ymd.
+		constexpr int32_t count(const serial& t)
+		{
+			return t.time_since_epoch().count();
+		}
+		constexpr int32_t count(const ymd& t)
+		{
+			return days_from_civil(t);
+		}
+
+		// 30/360 year fractions of n date pairs in blocks. European if E is true.
+		template<bool E, class T>
+		inline void _30_360_n(const T* t0, const T* t1, size_t n, double* out)
+		{
+#ifdef FMS_DATE_AVX2
+			if (kernel::avx2()) {
+				return kernel::_30_360_n_avx2<E>(t0, t1, n, out);
+			}
+#endif
+			kernel::_30_360_n<E>(t0, t1, n, out);
+		}
+
+		// Actual days divided by basis for n date pairs.
+		template<class T>
+		inline void _actual_n(const T* t0, const T* t1, size_t n, double basis, double* out)
+		{
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = (count(t1[i]) - count(t0[i])) / basis;
+			}
+		}
+
+		// Year fractions of n date pairs with the convention dispatched once outside the loop.
+		// 30/360 conventions convert serial dates to fields block by block. When the same
+		// dates are used again it is faster to convert them once with to_ymd.
+		template<class T>
+		inline bool batch_n(day_count dc, const T* t0, const T* t1, size_t n, double* out)
+		{
+			switch (dc) {
+			case day_count::_years:
+				for (size_t i = 0; i < n; ++i) {
+					out[i] = years(std::chrono::days(count(t1[i]) - count(t0[i]))).count();
+				}
+				return true;
+			case day_count::_30_360:
+				_30_360_n<false>(t0, t1, n, out);
+				return true;
+			case day_count::_30E_360:
+				_30_360_n<true>(t0, t1, n, out);
+				return true;
+			case day_count::_actual_360:
+				_actual_n(t0, t1, n, 360., out);
+				return true;
+			case day_count::_actual_365:
+				_actual_n(t0, t1, n, 365., out);
+				return true;
+			default:
+				return false;
+			}
+		}
+
+		// Year fractions of date pairs. Return the number of fractions computed.
+		inline size_t batch(day_count dc, std::span<const serial> t0, std::span<const serial> t1, std::span<double> out)
+		{
+			const size_t n = std::min({ t0.size(), t1.size(), out.size() });
+
+			return batch_n(dc, t0.data(), t1.data(), n, out.data()) ? n : 0;
+		}
+		inline size_t batch(day_count dc, std::span<const ymd> t0, std::span<const ymd> t1, std::span<double> out)
+		{
+			const size_t n = std::min({ t0.size(), t1.size(), out.size() });
+
+			return batch_n(dc, t0.data(), t1.data(), n, out.data()) ? n : 0;
+		}
+
+	} // namespace dcf
+
+#ifdef _DEBUG
+	inline int batch_test()
+	{
+		{
+			static_assert(days_from_civil(make_ymd(1970, 1, 1)) == 0);
+			static_assert(days_from_civil(make_ymd(2023, 4, 5)) == make_serial(2023, 4, 5).time_since_epoch().count());
+			static_assert(days_from_civil(make_ymd(-32767, 1, 1)) == make_serial(-32767, 1, 1).time_since_epoch().count());
+			static_assert(days_from_civil(make_ymd(32767, 12, 31)) == make_serial(32767, 12, 31).time_since_epoch().count());
+			static_assert(civil_from_days(days_from_civil(make_ymd(-32767, 1, 1))) == make_ymd(-32767, 1, 1));
+			static_assert(civil_from_days(days_from_civil(make_ymd(32767, 12, 31))) == make_ymd(32767, 12, 31));
+			static_assert(civil_from_days(0) == make_ymd(1970, 1, 1));
+			static_assert(civil_from_days(-1) == make_ymd(1969, 12, 31));
+			static_assert(civil_from_days(make_serial(2024, 2, 29).time_since_epoch().count()) == make_ymd(2024, 2, 29));
+		}
+		{
+			// bit identical to <chrono>
+			const auto s0 = make_serial(1600, 1, 1);
+			const auto s1 = make_serial(2400, 1, 1);
+			for (auto s = s0; s < s1; s += serial::duration(1)) {
+				assert(civil_from_days(s.time_since_epoch().count()) == to_ymd(s));
+				assert(days_from_civil(to_ymd(s)) == s.time_since_epoch().count());
+			}
+
+			// dispatched and portable kernels over whole and partial blocks
+			const size_t n = (s1 - s0).count() - 7;
+			std::vector<serial> s(n), t(n);
+			std::vector<ymd> d(n), e(n);
+			for (size_t i = 0; i < n; ++i) {
+				s[i] = s0 + serial::duration(i);
+			}
+			[[maybe_unused]] size_t k = to_ymd(s, d);
+			assert(k == n);
+			kernel::to_ymd_n(s.data(), n, e.data());
+			assert(d == e);
+			for (size_t i = 0; i < n; ++i) {
+				assert(d[i] == to_ymd(s[i]));
+			}
+			k = to_serial(d, t);
+			assert(k == n);
+			assert(t == s);
+			kernel::to_serial_n(d.data(), n, t.data());
+			assert(t == s);
+		}
+		{
+			const ymd d[] = { make_ymd(1900, 3, 1), make_ymd(2023, 4, 5), make_ymd(2024, 2, 29) };
+			int32_t s[3];
+			serial t[4];
+			ymd e[3];
+			[[maybe_unused]] const size_t ks = to_serial(d, s);
+			[[maybe_unused]] const size_t kt = to_serial(d, t);
+			assert(ks == 3 and kt == 3);
+			for (size_t i = 0; i < 3; ++i) {
+				assert(s[i] == to_serial(d[i]).time_since_epoch().count());
+				assert(t[i] == to_serial(d[i]));
+			}
+			[[maybe_unused]] const size_t ke = to_ymd(s, e);
+			assert(ke == 3);
+			assert(std::equal(d, d + 3, e));
+			[[maybe_unused]] const size_t k2 = to_ymd(std::span<const serial>(t, 2), e);
+			assert(k2 == 2);
+		}
+		{
+			const serial t0[] = {
+				make_serial(2003, 12, 29), make_serial(2003, 12, 31), make_serial(2004, 1, 30),
+				make_serial(2004, 2, 29), make_serial(2023, 1, 31), make_serial(1999, 3, 31),
+			};
+			const serial t1[] = {
+				make_serial(2004, 1, 31), make_serial(2004, 1, 31), make_serial(2004, 3, 31),
+				make_serial(2024, 8, 31), make_serial(2023, 1, 31), make_serial(2023, 2, 28),
+			};
+			constexpr struct {
+				day_count dc;
+				dcf_ f;
+			} dcfs[] = {
+				{ day_count::_years, dcf::_years },
+				{ day_count::_30_360, dcf::_30_360 },
+				{ day_count::_30E_360, dcf::_30E_360 },
+				{ day_count::_actual_360, dcf::_actual_360 },
+				{ day_count::_actual_365, dcf::_actual_365 },
+			};
+			double out[6];
+			for (const auto& [dc, f] : dcfs) {
+				[[maybe_unused]] const size_t k = dcf::batch(dc, t0, t1, out);
+				assert(k == 6);
+				for (size_t i = 0; i < 6; ++i) {
+					assert(out[i] == f(to_ymd(t0[i]), to_ymd(t1[i])).count());
+				}
+			}
+			[[maybe_unused]] const size_t k = dcf::batch(day_count::_actual_360, t0, t1, std::span(out, 2));
+			assert(k == 2);
+
+			ymd d0[6], d1[6];
+			to_ymd(t0, d0);
+			to_ymd(t1, d1);
+			for (const auto& [dc, f] : dcfs) {
+				[[maybe_unused]] const size_t k = dcf::batch(dc, d0, d1, out);
+				assert(k == 6);
+				for (size_t i = 0; i < 6; ++i) {
+					assert(out[i] == f(d0[i], d1[i]).count());
+				}
+			}
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
@@ -0,0 +1,427 @@
+// fms_date_bench.cpp - Benchmarks. Configure with -DCMAKE_BUILD_TYPE=Release.
+#undef _DEBUG // tests are run by fms_date
+#include <algorithm>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fms_date.h"
+#include "fms_date_batch.h"
+#include "fms_date_calendar.h"
+#include "fms_date_calendar_file.h"
+#include "fms_date_excel.h"
+#include "fms_date_holiday.h"
+#include "fms_date_registry.h"
+#include "fms_date_text.h"
+
+using namespace fms::date;
+
+// Defeat dead code elimination.
+volatile int64_t sink;
+
+// Best time in nanoseconds per item of f() over n items.
+template<class F>
+inline double timeit(F f, size_t n, int reps = 10)
+{
+	using clock = std::chrono::steady_clock;
+
+	double t = std::numeric_limits<double>::max();
+	for (int i = 0; i < reps; ++i) {
+		const auto t0 = clock::now();
+		f();
+		const auto t1 = clock::now();
+		t = std::min(t, std::chrono::duration<double, std::nano>(t1 - t0).count() / n);
+	}
+
+	return t;
+}
+
+inline void report(const char* name, double base, double fast)
+{
+	printf("%-32s %8.3f ns %8.3f ns %6.2fx\n", name, base, fast, base / fast);
+}
+
+// Random serial dates in [1950, 2100).
+inline std::vector<serial> random_serial(size_t n, unsigned seed = 1)
+{
+	std::mt19937 gen(seed);
+	const auto s0 = make_serial(1950, 1, 1).time_since_epoch().count();
+	const auto s1 = make_serial(2100, 1, 1).time_since_epoch().count();
+	std::uniform_int_distribution<int32_t> u(s0, s1 - 1);
+
+	std::vector<serial> s(n);
+	for (auto& si : s) {
+		si = serial(serial::duration(u(gen)));
+	}
+
+	return s;
+}
+
+inline std::vector<ymd> random_ymd(size_t n, unsigned seed = 1)
+{
+	std::vector<ymd> d;
+	for (const auto& s : random_serial(n, seed)) {
+		d.push_back(to_ymd(s));
+	}
+
+	return d;
+}
+
+void bench_month_table(size_t n)
+{
+	const auto d = random_ymd(n);
+
+	report("ymd -> serial",
+		timeit([&] {
+			int64_t sum = 0;
+			for (const auto& di : d) {
+				sum += sys_days(di).time_since_epoch().count();
+			}
+			sink = sum;
+		}, n),
+		timeit([&] {
+			int64_t sum = 0;
+			for (const auto& di : d) {
+				sum += ymd_table.to_serial(di).time_since_epoch().count();
+			}
+			sink = sum;
+		}, n));
+}
+
+void bench_batch(size_t n)
+{
+	const auto d = random_ymd(n);
+	std::vector<int32_t> s(n);
+	std::vector<ymd> e(n);
+
+	report("to_serial(span)",
+		timeit([&] {
+			for (size_t i = 0; i < n; ++i) {
+				s[i] = to_serial(d[i]).time_since_epoch().count();
+			}
+			sink = s[n / 2];
+		}, n),
+		timeit([&] {
+			to_serial(d, s);
+			sink = s[n / 2];
+		}, n));
+	report("to_ymd(span)",
+		timeit([&] {
+			for (size_t i = 0; i < n; ++i) {
+				e[i] = to_ymd(serial(serial::duration(s[i])));
+			}
+			sink = (unsigned)e[n / 2].day();
+		}, n),
+		timeit([&] {
+			to_ymd(s, e);
+			sink = (unsigned)e[n / 2].day();
+		}, n));
+}
+
+void bench_dcf_batch(size_t n)
+{
+	const auto s0 = random_serial(n, 1);
+	const auto s1 = random_serial(n, 2);
+	std::vector<ymd> d0(n), d1(n);
+	to_ymd(s0, d0);
+	to_ymd(s1, d1);
+	std::vector<double> out(n);
+
+	static const struct {
+		const char* name;
+		day_count dc;
+		dcf_ f;
+	} dcfs[] = {
+		{ "dcf::batch _30_360", day_count::_30_360, dcf::_30_360 },
+		{ "dcf::batch _30E_360", day_count::_30E_360, dcf::_30E_360 },
+		{ "dcf::batch _actual_360", day_count::_actual_360, dcf::_actual_360 },
+		{ "dcf::batch _actual_365", day_count::_actual_365, dcf::_actual_365 },
+	};
+	for (const auto& [name, dc, f_] : dcfs) {
+		volatile dcf_ f = f_; // called through a pointer as in client code
+		report(name,
+			timeit([&] {
+				for (size_t i = 0; i < n; ++i) {
+					out[i] = f(d0[i], d1[i]).count();
+				}
+				sink = (int64_t)out[n / 2];
+			}, n),
+			timeit([&] {
+				dcf::batch(dc, d0, d1, out);
+				sink = (int64_t)out[n / 2];
+			}, n));
+	}
+	for (const auto& [name, dc, f_] : dcfs) {
+		volatile day_count dc_ = dc; // not known at compile time
+		report((std::string(name) + " serial").c_str(),
+			timeit([&] {
+				for (size_t i = 0; i < n; ++i) {
+					out[i] = dcf::year_fraction(dc_, s0[i], s1[i]).count();
+				}
+				sink = (int64_t)out[n / 2];
+			}, n),
+			timeit([&] {
+				dcf::batch(dc, s0, s1, out);
+				sink = (int64_t)out[n / 2];
+			}, n));
+	}
+}
+
+// Fixed convention over all periods of a schedule.
+template<day_count DC>
+void bench_dcf_dispatch(const char* name, size_t n)
+{
+	std::vector<ymd> d(n + 1);
+	for (size_t i = 0; i <= n; ++i) {
+		d[i] = make_ymd(2000, 1, 31) + std::chrono::months(3 * i);
+	}
+	std::vector<double> out(n);
+
+	volatile dcf_ f = dcf::function(DC);
+	report(name,
+		timeit([&] {
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = f(d[i], d[i + 1]).count();
+			}
+			sink = (int64_t)out[n / 2];
+		}, n),
+		timeit([&] {
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = dcf::year_fraction<DC>(d[i], d[i + 1]).count();
+			}
+			sink = (int64_t)out[n / 2];
+		}, n));
+}
+
+void bench_adjust(size_t n)
+{
+	const auto s = random_serial(n);
+	std::vector<serial> out(n);
+	const compiled_calendar c(calendars::example);
+
+	const auto scalar = timeit([&] {
+		for (size_t i = 0; i < n; ++i) {
+			out[i] = adjust(s[i], roll::modified_following, calendars::example);
+		}
+		sink = out[n / 2].time_since_epoch().count();
+	}, n);
+	report("adjust(span) calendar", scalar,
+		timeit([&] {
+			adjust(s, out, roll::modified_following, calendars::example);
+			sink = out[n / 2].time_since_epoch().count();
+		}, n));
+	report("adjust(span) compiled", scalar,
+		timeit([&] {
+			adjust(s, out, roll::modified_following, c);
+			sink = out[n / 2].time_since_epoch().count();
+		}, n));
+	const roll_table t(c);
+	printf("roll_table bytes %zu, compiled_calendar bytes %zu\n", t.bytes(), c.bytes());
+	report("adjust(span) roll_table", scalar,
+		timeit([&] {
+			adjust(s, out, roll::modified_following, t);
+			sink = out[n / 2].time_since_epoch().count();
+		}, n));
+	printf("hardware threads %u\n", std::thread::hardware_concurrency()); // 4 threads only help with 4 cores
+	report("adjust(span) compiled 4 threads", scalar,
+		timeit([&] {
+			adjust(s, out, roll::modified_following, c, 4);
+			sink = out[n / 2].time_since_epoch().count();
+		}, n));
+}
+
+void bench_joint()
+{
+	const auto& nyse = calendars::compiled::nyse();
+	const auto& target = calendars::compiled::target();
+	const size_t days = (nyse.end() - nyse.begin()).count();
+
+	report("joint calendar per day",
+		timeit([&] {
+			const compiled_calendar c([](const ymd& d) { return calendars::nyse(d) or calendars::target(d); });
+			sink = c.bytes();
+		}, days, 3),
+		timeit([&] {
+			const auto c = nyse | target;
+			sink = c.bytes();
+		}, days));
+}
+
+// Build a 1900-2200 weekend bitmap by evaluating a predicate or copying the mask pattern.
+void bench_weekend()
+{
+	const auto from = make_serial(1900, 1, 1);
+	const auto to = make_serial(2201, 1, 1);
+	const size_t days = (to - from).count();
+
+	report("weekend calendar per day",
+		timeit([&] {
+			const compiled_calendar c(calendars::weekend_days<calendars::friday_saturday.mask>, from, to);
+			sink = c.bytes();
+		}, days, 3),
+		timeit([&] {
+			const compiled_calendar c(calendars::friday_saturday, from, to);
+			sink = c.bytes();
+		}, days));
+}
+
+// Load a calendar by compiling holiday rules or by mapping a calendar file.
+void bench_calendar_file()
+{
+	const char* path = "fms_date_bench.cal";
+	if (!write(calendars::compiled::nyse(), path)) {
+		return;
+	}
+
+	report("load calendar",
+		timeit([&] {
+			const auto c = compile(holidays::nyse, calendars::nyse);
+			sink = c.bytes();
+		}, 1, 3),
+		timeit([&] {
+			const auto c = map_calendar(path, calendars::nyse);
+			sink = c ? c->bytes() : 0;
+		}, 1));
+	std::remove(path);
+}
+
+// Resolve a joint calendar through the locked cache or the registry.
+void bench_registry(size_t n)
+{
+	const auto& nyse = calendars::compiled::nyse();
+	const auto& target = calendars::compiled::target();
+	joint_calendars joint;
+	calendar_registry r;
+	r.add_exchanges();
+	r("NYSE+TARGET");
+
+	report("joint calendar lookup",
+		timeit([&] {
+			int64_t sum = 0;
+			for (size_t i = 0; i < n; ++i) {
+				sum += joint({ &nyse, &target }).bytes();
+			}
+			sink = sum;
+		}, n),
+		timeit([&] {
+			int64_t sum = 0;
+			for (size_t i = 0; i < n; ++i) {
+				const calendar_registry::reader g(r);
+				sum += g.find("NYSE+TARGET")->bytes();
+			}
+			sink = sum;
+		}, n));
+}
+
+// Parse ISO and compact date strings with sscanf or parse_dates.
+void bench_parse(size_t n)
+{
+	const auto dates = random_ymd(n);
+	std::vector<std::string> text(n);
+	for (size_t i = 0; i < n; ++i) {
+		char buf[16];
+		snprintf(buf, sizeof(buf), i % 2 ? "%04d-%02u-%02u" : "%04d%02u%02u", (int)dates[i].year(), (unsigned)dates[i].month(), (unsigned)dates[i].day());
+		text[i] = buf;
+	}
+	const std::vector<std::string_view> t(text.begin(), text.end());
+	std::vector<serial> s(n);
+
+	report("parse_dates sscanf",
+		timeit([&] {
+			for (size_t i = 0; i < n; ++i) {
+				int y = 0;
+				unsigned m = 0, d = 0;
+				if (t[i].size() == 10) {
+					sscanf(t[i].data(), "%4d-%2u-%2u", &y, &m, &d);
+				}
+				else {
+					sscanf(t[i].data(), "%4d%2u%2u", &y, &m, &d);
+				}
+				s[i] = to_serial(make_ymd(y, m, d));
+			}
+			sink = s[n / 2].time_since_epoch().count();
+		}, n),
+		timeit([&] {
+			sink = parse_dates(t, s);
+		}, n));
+}
+
+// Format dates one at a time with snprintf or into one buffer of fixed width records.
+void bench_format(size_t n)
+{
+	const auto s = random_serial(n);
+	std::vector<char> out(n * (width(date_format::iso) + 1) + 1); // room for the last snprintf terminator
+
+	const auto base = timeit([&] {
+		char* p = out.data();
+		for (size_t i = 0; i < n; ++i) {
+			const auto d = to_ymd(s[i]);
+			p += snprintf(p, 12, "%04d-%02u-%02u\n", (int)d.year(), (unsigned)d.month(), (unsigned)d.day());
+		}
+		sink = out[n / 2];
+	}, n);
+	const auto fast = timeit([&] {
+		sink = format_dates(s, out, date_format::iso, '\n');
+	}, n);
+	report("format_dates", base, fast);
+	printf("%-32s %8.1f M/s %8.1f M/s\n", "format_dates dates/second", 1e3 / base, 1e3 / fast);
+}
+
+// Convert Excel serial numbers through ymd or directly.
+void bench_excel(size_t n)
+{
+	const auto s = random_serial(n);
+	std::vector<double> x(n);
+	to_excel(s, x);
+	std::vector<serial> out(n);
+
+	report("from_excel(span)",
+		timeit([&] {
+			const auto d0 = make_ymd(1899, 12, 30);
+			for (size_t i = 0; i < n; ++i) {
+				const auto d = ymd(sys_days(d0) + std::chrono::days((int)x[i]));
+				out[i] = to_serial(d);
+			}
+			sink = out[n / 2].time_since_epoch().count();
+		}, n),
+		timeit([&] {
+			from_excel(x, out);
+			sink = out[n / 2].time_since_epoch().count();
+		}, n));
+	report("to_excel(span)",
+		timeit([&] {
+			const auto d0 = sys_days(make_ymd(1899, 12, 30));
+			for (size_t i = 0; i < n; ++i) {
+				x[i] = (sys_days(to_ymd(s[i])) - d0).count();
+			}
+			sink = (int64_t)x[n / 2];
+		}, n),
+		timeit([&] {
+			to_excel(s, x);
+			sink = (int64_t)x[n / 2];
+		}, n));
+}
+
+int main()
+{
+	constexpr size_t n = 1'000'000;
+
+	printf("%-32s %11s %11s %7s\n", "benchmark", "baseline", "fast", "speedup");
+	bench_month_table(n);
+	bench_batch(n);
+	bench_dcf_batch(n);
+	bench_dcf_dispatch<day_count::_30_360>("year_fraction<_30_360>", 1000);
+	bench_dcf_dispatch<day_count::_actual_360>("year_fraction<_actual_360>", 1000);
+	bench_adjust(n);
+	bench_joint();
+	bench_weekend();
+	bench_calendar_file();
+	bench_registry(n);
+	bench_parse(n);
+	bench_format(n);
+	bench_excel(n);
+
+	return 0;
+}
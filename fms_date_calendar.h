@@ -0,0 +1,835 @@
+// fms_date_calendar.h - Business day calendars compiled to bitmaps
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <thread>
+#include <vector>
+#include "fms_date.h"
+
+namespace fms::date {
+
+	// The n-th business day after d, or before d if n is negative, one day at a time.
+	// Cal is a calendar or has the same semantics.
+	template<class Cal>
+	constexpr serial add_business_days(serial d, int32_t n, const Cal& cal)
+	{
+		const auto step = serial::duration(n < 0 ? -1 : 1);
+		for (; n != 0; n -= step.count()) {
+			do {
+				d += step;
+			} while (cal(to_ymd(d)));
+		}
+
+		return d;
+	}
+
+	// Business days over a range of serial dates stored one bit per day.
+	// The range starts on a multiple of 64 days since 1970-01-01 so
+	// calendars covering the same dates have aligned words.
+	// Words are immutable and shared by copies. Modifying a calendar builds new words.
+	class compiled_calendar {
+		static constexpr uint32_t zero = 0;
+		int32_t first = 0; // serial date of bit 0
+		int32_t n = 0; // number of words
+		const uint64_t* bits = nullptr; // bit set on business days
+		const uint32_t* ranks = &zero; // business days before each word, n + 1 entries
+		std::shared_ptr<const void> data; // owns bits and ranks
+		calendar cal; // dates outside the range
+	public:
+		compiled_calendar()
+			: cal{ calendars::weekday }
+		{ }
+		// Evaluate cal once for every day in [from, to) rounded out to whole words.
+		// Dates outside the range use fallback, or cal if it is null.
+		explicit compiled_calendar(const calendar& cal, serial from = make_serial(1900, 1, 1), serial to = make_serial(2201, 1, 1), const calendar& fallback = nullptr)
+			: first{ from.time_since_epoch().count() & ~63 }, cal{ fallback ? fallback : cal }
+		{
+			const int32_t last = to.time_since_epoch().count();
+			std::vector<uint64_t> words;
+			if (last > first) {
+				words.resize((last - first + 63) / 64);
+			}
+
+			auto s = serial(serial::duration(first));
+			for (auto& w : words) {
+				for (int i = 0; i < 64; ++i, s += serial::duration(1)) {
+					if (!cal(to_ymd(s))) {
+						w |= uint64_t(1) << i;
+					}
+				}
+			}
+			assign(std::move(words));
+		}
+		// Weekend days in [from, to) rounded out to whole words.
+		// The pattern repeats every 7 days and 64 = 1 mod 7, so there are 7 distinct
+		// words that are built with shifts and copied across the range.
+		// Dates outside the range use fallback, or weekend if it is null.
+		compiled_calendar(const calendars::weekend& weekend, serial from, serial to, const calendar& fallback = nullptr)
+			: first{ from.time_since_epoch().count() & ~63 }, cal{ fallback ? fallback : calendar(weekend) }
+		{
+			const int32_t last = to.time_since_epoch().count();
+			std::vector<uint64_t> words;
+			if (last > first) {
+				words.resize((last - first + 63) / 64);
+			}
+
+			// weekday of bit 0, 1970-01-01 is a Thursday
+			const unsigned w0 = (unsigned)(((first + 4) % 7 + 7) % 7);
+			uint64_t phase[7]; // business days of the 64 days starting 64 k days after first for k mod 7
+			for (unsigned k = 0; k < 7; ++k) {
+				uint64_t p = 0; // business days of the 7 days starting k days after first
+				for (unsigned j = 0; j < 7; ++j) {
+					p |= uint64_t(!((weekend.mask >> ((w0 + k + j) % 7)) & 1)) << j;
+				}
+				p |= p << 7;
+				p |= p << 14;
+				p |= p << 28;
+				p |= p << 56;
+				phase[k] = p;
+			}
+			for (size_t w = 0; w < words.size(); ++w) {
+				words[w] = phase[w % 7];
+			}
+			assign(std::move(words));
+		}
+		// View of n words and n + 1 prefix counts starting at serial date first owned by data.
+		// Nothing is copied so the words can live in a memory mapped file.
+		compiled_calendar(std::shared_ptr<const void> data, int32_t first, int32_t n, const uint64_t* bits, const uint32_t* ranks, const calendar& fallback)
+			: first{ first }, n{ n }, bits{ bits }, ranks{ ranks }, data{ std::move(data) }, cal{ fallback }
+		{ }
+
+		// First date in the bitmap.
+		serial begin() const
+		{
+			return serial(serial::duration(first));
+		}
+		// One past the last date in the bitmap.
+		serial end() const
+		{
+			return serial(serial::duration(first + 64 * n));
+		}
+		// Memory used by the bitmap and prefix counts.
+		size_t bytes() const
+		{
+			return n * sizeof(bits[0]) + (n + 1) * sizeof(ranks[0]);
+		}
+		bool contains(const serial& s) const
+		{
+			return begin() <= s and s < end();
+		}
+		// Business day words and prefix counts.
+		std::span<const uint64_t> words() const
+		{
+			return { bits, (size_t)n };
+		}
+		std::span<const uint32_t> prefix_counts() const
+		{
+			return { ranks, (size_t)n + 1 };
+		}
+		// Dates outside the range.
+		const calendar& fallback() const
+		{
+			return cal;
+		}
+
+		// Make dates in range non-business days.
+		compiled_calendar& close(std::span<const serial> dates)
+		{
+			std::vector<uint64_t> words(bits, bits + n);
+			for (const auto& s : dates) {
+				const auto i = s.time_since_epoch().count() - first;
+				if (0 <= i and i < 64 * n) {
+					words[i >> 6] &= ~(uint64_t(1) << (i & 63));
+				}
+			}
+			assign(std::move(words));
+
+			return *this;
+		}
+
+		// Single bit test for dates in range.
+		bool is_business_day(const serial& s) const
+		{
+			const auto i = s.time_since_epoch().count() - first;
+			if (0 <= i and i < 64 * n) {
+				return (bits[i >> 6] >> (i & 63)) & 1;
+			}
+
+			return !cal(to_ymd(s));
+		}
+		// Same semantics as calendar: true on non-business days.
+		bool operator()(const ymd& d) const
+		{
+			return !is_business_day(to_serial(d));
+		}
+
+		// Number of business days in [begin(), s) for s in [begin(), end()].
+		int32_t rank(const serial& s) const
+		{
+			const auto i = s.time_since_epoch().count() - first;
+			const auto w = i >> 6;
+			const auto b = i & 63;
+			if (b == 0) {
+				return ranks[w];
+			}
+
+			return ranks[w] + std::popcount(bits[w] & ((uint64_t(1) << b) - 1));
+		}
+
+		// Number of business days in [d0, d1), negative if d1 < d0.
+		// Two table lookups in range, one day at a time outside it.
+		int32_t business_days(const serial& d0, const serial& d1) const
+		{
+			if (d1 < d0) {
+				return -business_days(d1, d0);
+			}
+
+			int32_t m = 0;
+			const auto lo = std::clamp(d0, begin(), end());
+			const auto hi = std::clamp(d1, begin(), end());
+			for (auto s = d0; s < std::min(d1, lo); s += serial::duration(1)) {
+				m += is_business_day(s);
+			}
+			if (lo < hi) {
+				m += rank(hi) - rank(lo);
+			}
+			for (auto s = std::max(d0, hi); s < d1; s += serial::duration(1)) {
+				m += is_business_day(s);
+			}
+
+			return m;
+		}
+
+		// Business day with k business days before it in the range, k < rank(end()).
+		// Binary search of the prefix counts and a select in the word.
+		serial select(int32_t k) const
+		{
+			const auto w = std::upper_bound(ranks, ranks + n + 1, (uint32_t)k) - ranks - 1;
+
+			return begin() + serial::duration(64 * (int32_t)w + select(bits[w], k - ranks[w]));
+		}
+
+		// The n-th business day after d, or before d if n is negative.
+		serial add_business_days(const serial& d, int32_t n) const
+		{
+			if (n > 0 and begin() <= d and d < end()) {
+				const auto k = rank(d + serial::duration(1)) + n - 1;
+				if (k < rank(end())) {
+					return select(k);
+				}
+			}
+			else if (n < 0 and begin() <= d and d <= end()) {
+				const auto k = rank(d) + n;
+				if (k >= 0) {
+					return select(k);
+				}
+			}
+
+			return fms::date::add_business_days(d, n, *this);
+		}
+
+		// First business day on or after s.
+		// Scans 64 days at a time with count trailing zeros in range.
+		serial next_business_day(serial s) const
+		{
+			const auto i = s.time_since_epoch().count() - first;
+			if (0 <= i and i < 64 * n) {
+				auto w = i >> 6;
+				auto m = bits[w] & (~uint64_t(0) << (i & 63));
+				while (m == 0 and w + 1 < n) {
+					m = bits[++w];
+				}
+				if (m) {
+					return begin() + serial::duration(64 * w + std::countr_zero(m));
+				}
+				s = end();
+			}
+			while (!is_business_day(s)) {
+				s += serial::duration(1);
+			}
+
+			return s;
+		}
+		// Last business day on or before s.
+		// Scans 64 days at a time with count leading zeros in range.
+		serial previous_business_day(serial s) const
+		{
+			const auto i = s.time_since_epoch().count() - first;
+			if (0 <= i and i < 64 * n) {
+				auto w = i >> 6;
+				auto m = bits[w] & (~uint64_t(0) >> (63 - (i & 63)));
+				while (m == 0 and w > 0) {
+					m = bits[--w];
+				}
+				if (m) {
+					return begin() + serial::duration(64 * w + 63 - std::countl_zero(m));
+				}
+				s = begin() - serial::duration(1);
+			}
+			while (!is_business_day(s)) {
+				s -= serial::duration(1);
+			}
+
+			return s;
+		}
+
+		// Combine business day words of a and b with op over the union of their ranges.
+		// Words outside the range of one operand are computed from its fallback.
+		// An empty operand contributes only its fallback words.
+		// Dates outside both ranges use the fallback of a.
+		template<class Op>
+		static compiled_calendar combine(const compiled_calendar& a, const compiled_calendar& b, Op op)
+		{
+			if (a.n == 0 and b.n == 0) {
+				return a;
+			}
+
+			compiled_calendar c;
+			c.cal = a.cal;
+			c.first = a.n == 0 ? b.first : b.n == 0 ? a.first : std::min(a.first, b.first);
+			const int32_t last = a.n == 0 ? b.first + 64 * b.n : b.n == 0 ? a.first + 64 * a.n
+				: std::max(a.first + 64 * a.n, b.first + 64 * b.n);
+			std::vector<uint64_t> words((last - c.first) / 64);
+			// word offsets of the operands in c, both are multiples of 64 days
+			const int32_t ia = (a.first - c.first) / 64;
+			const int32_t ib = (b.first - c.first) / 64;
+			const int32_t nc = (int32_t)words.size();
+			if (ia == 0 and ib == 0 and a.n == b.n) {
+				// common case is branch free and vectorizes
+				const uint64_t* pa = a.bits;
+				const uint64_t* pb = b.bits;
+				uint64_t* pc = words.data();
+				for (int32_t w = 0; w < nc; ++w) {
+					pc[w] = op(pa[w], pb[w]);
+				}
+			}
+			else {
+				for (int32_t w = 0; w < nc; ++w) {
+					const auto wa = ia <= w and w < ia + a.n ? a.bits[w - ia] : a.word(c.first + 64 * w);
+					const auto wb = ib <= w and w < ib + b.n ? b.bits[w - ib] : b.word(c.first + 64 * w);
+					words[w] = op(wa, wb);
+				}
+			}
+			c.assign(std::move(words));
+
+			return c;
+		}
+		// Non-business day if either is: union of holidays.
+		friend compiled_calendar operator|(const compiled_calendar& a, const compiled_calendar& b)
+		{
+			return combine(a, b, [](uint64_t x, uint64_t y) { return x & y; });
+		}
+		// Non-business day if both are: intersection of holidays.
+		friend compiled_calendar operator&(const compiled_calendar& a, const compiled_calendar& b)
+		{
+			return combine(a, b, [](uint64_t x, uint64_t y) { return x | y; });
+		}
+		// Non-business day of a that is a business day of b: difference of holidays.
+		friend compiled_calendar operator-(const compiled_calendar& a, const compiled_calendar& b)
+		{
+			return combine(a, b, [](uint64_t x, uint64_t y) { return x | ~y; });
+		}
+	private:
+		// Business day bits of the 64 days starting at serial date s using the fallback.
+		uint64_t word(int32_t s) const
+		{
+			uint64_t w = 0;
+			for (int i = 0; i < 64; ++i) {
+				if (!cal(to_ymd(serial(serial::duration(s + i))))) {
+					w |= uint64_t(1) << i;
+				}
+			}
+
+			return w;
+		}
+		// Position of the r-th set bit of w, r < popcount(w).
+		static constexpr int32_t select(uint64_t w, int32_t r)
+		{
+			int32_t i = 0;
+			for (int width = 32; width; width >>= 1) {
+				const int32_t m = std::popcount(w & ((uint64_t(1) << width) - 1));
+				if (r >= m) {
+					r -= m;
+					w >>= width;
+					i += width;
+				}
+			}
+
+			return i;
+		}
+		// Own words and their prefix counts of business days.
+		void assign(std::vector<uint64_t>&& words)
+		{
+			struct storage {
+				std::vector<uint64_t> bits;
+				std::vector<uint32_t> ranks;
+			};
+			auto p = std::make_shared<storage>();
+			p->bits = std::move(words);
+			p->ranks.resize(p->bits.size() + 1);
+			for (size_t w = 0; w < p->bits.size(); ++w) {
+				p->ranks[w + 1] = p->ranks[w] + std::popcount(p->bits[w]);
+			}
+			n = (int32_t)p->bits.size();
+			bits = p->bits.data();
+			ranks = p->ranks.data();
+			data = std::move(p);
+		}
+	};
+
+	// Joint calendars built once and shared.
+	// Constituents are identified by address and must outlive the cache.
+	class joint_calendars {
+		std::mutex mutex;
+		std::map<std::vector<const compiled_calendar*>, compiled_calendar> cache;
+	public:
+		// Union of holidays of cals. References stay valid for the lifetime of the cache.
+		const compiled_calendar& operator()(std::initializer_list<const compiled_calendar*> cals)
+		{
+			std::vector<const compiled_calendar*> key(cals);
+			std::sort(key.begin(), key.end());
+			key.erase(std::unique(key.begin(), key.end()), key.end());
+
+			std::lock_guard lock(mutex);
+			auto i = cache.find(key);
+			if (i == cache.end()) {
+				compiled_calendar c = key.empty() ? compiled_calendar{} : *key[0];
+				for (size_t j = 1; j < key.size(); ++j) {
+					c = c | *key[j];
+				}
+				i = cache.emplace(std::move(key), std::move(c)).first;
+			}
+
+			return i->second;
+		}
+		size_t size()
+		{
+			std::lock_guard lock(mutex);
+
+			return cache.size();
+		}
+	};
+
+	// Number of business days in [d0, d1), negative if d1 < d0.
+	constexpr int32_t business_days(const serial& d0, const serial& d1, const calendar& cal)
+	{
+		if (d1 < d0) {
+			return -business_days(d1, d0, cal);
+		}
+
+		int32_t n = 0;
+		for (auto s = d0; s < d1; s += serial::duration(1)) {
+			n += !cal(to_ymd(s));
+		}
+
+		return n;
+	}
+	inline int32_t business_days(const serial& d0, const serial& d1, const compiled_calendar& cal)
+	{
+		return cal.business_days(d0, d1);
+	}
+
+	inline serial add_business_days(const serial& d, int32_t n, const compiled_calendar& cal)
+	{
+		return cal.add_business_days(d, n);
+	}
+
+	// Roll with bit scans. Modified conventions compare against the month
+	// bounds of date instead of converting the rolled date.
+	inline serial adjust(const serial& date, roll convention, const compiled_calendar& cal)
+	{
+		if (cal.is_business_day(date)) {
+			return date;
+		}
+
+		switch (convention) {
+		case roll::none:
+			return date;
+		case roll::following:
+			return cal.next_business_day(date);
+		case roll::previous:
+			return cal.previous_business_day(date);
+		case roll::modified_following:
+		{
+			const auto d = to_ymd(date);
+			const auto eom = date + serial::duration((unsigned)(d.year() / d.month() / std::chrono::last).day() - (unsigned)d.day());
+			const auto date_ = cal.next_business_day(date);
+			return date_ <= eom ? date_ : cal.previous_business_day(date);
+		}
+		case roll::modified_previous:
+		{
+			const auto bom = date - serial::duration((unsigned)to_ymd(date).day() - 1);
+			const auto date_ = cal.previous_business_day(date);
+			return date_ >= bom ? date_ : cal.next_business_day(date);
+		}
+		default:
+			return serial{};
+		}
+	}
+	inline ymd adjust(const ymd& date, roll convention, const compiled_calendar& cal)
+	{
+		return to_ymd(adjust(to_serial(date), convention, cal));
+	}
+
+	// Offset from every day in the range of a compiled calendar to its adjusted
+	// date for each roll convention so adjusting is a single indexed load.
+	class roll_table {
+		int32_t first;
+		// following, previous, modified_following, modified_previous
+		std::vector<std::array<int8_t, 4>> offsets;
+		compiled_calendar cal; // offsets that do not fit and dates outside the range
+		static constexpr int8_t overflow = std::numeric_limits<int8_t>::min();
+	public:
+		explicit roll_table(const compiled_calendar& cal)
+			: first{ cal.begin().time_since_epoch().count() }, offsets((cal.end() - cal.begin()).count()), cal{ cal }
+		{
+			constexpr roll rolls[] = { roll::following, roll::previous, roll::modified_following, roll::modified_previous };
+			auto s = cal.begin();
+			for (auto& o : offsets) {
+				for (int j = 0; j < 4; ++j) {
+					const auto n = (fms::date::adjust(s, rolls[j], cal) - s).count();
+					o[j] = (overflow < n and n <= std::numeric_limits<int8_t>::max()) ? static_cast<int8_t>(n) : overflow;
+				}
+				s += serial::duration(1);
+			}
+		}
+
+		// Memory used by the offsets.
+		size_t bytes() const
+		{
+			return offsets.size() * sizeof(offsets[0]);
+		}
+
+		serial adjust(const serial& d, roll convention) const
+		{
+			const auto i = d.time_since_epoch().count() - first;
+			const auto j = static_cast<int>(convention) - static_cast<int>(roll::following);
+			if (0 <= i and i < (int32_t)offsets.size() and 0 <= j and j < 4) {
+				const auto n = offsets[i][j];
+				if (n != overflow) {
+					return d + serial::duration(n);
+				}
+			}
+
+			return fms::date::adjust(d, convention, cal);
+		}
+	};
+
+	inline serial adjust(const serial& date, roll convention, const roll_table& table)
+	{
+		return table.adjust(date, convention);
+	}
+
+	// Adjust n dates with the convention switch outside the loop.
+	// Cal is a calendar or compiled_calendar.
+	template<class Cal>
+	inline void adjust_n(const serial* in, size_t n, serial* out, roll convention, const Cal& cal)
+	{
+		switch (convention) {
+		case roll::none:
+			std::copy(in, in + n, out);
+			break;
+		case roll::following:
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = adjust(in[i], roll::following, cal);
+			}
+			break;
+		case roll::previous:
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = adjust(in[i], roll::previous, cal);
+			}
+			break;
+		case roll::modified_following:
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = adjust(in[i], roll::modified_following, cal);
+			}
+			break;
+		case roll::modified_previous:
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = adjust(in[i], roll::modified_previous, cal);
+			}
+			break;
+		default:
+			for (size_t i = 0; i < n; ++i) {
+				out[i] = adjust(in[i], convention, cal);
+			}
+		}
+	}
+
+	// Adjust n dates in chunks on up to threads threads.
+	template<class Cal>
+	inline void adjust_n(const serial* in, size_t n, serial* out, roll convention, const Cal& cal, unsigned threads)
+	{
+		constexpr size_t min_chunk = 1 << 12;
+		const size_t m = std::min<size_t>(std::max(threads, 1u), (n + min_chunk - 1) / min_chunk);
+		if (m <= 1) {
+			adjust_n(in, n, out, convention, cal);
+
+			return;
+		}
+
+		std::vector<std::thread> chunks;
+		const size_t k = (n + m - 1) / m;
+		for (size_t i = k; i < n; i += k) {
+			chunks.emplace_back([=, &cal] { adjust_n(in + i, std::min(k, n - i), out + i, convention, cal); });
+		}
+		adjust_n(in, k, out, convention, cal);
+		for (auto& t : chunks) {
+			t.join();
+		}
+	}
+
+	// Adjust dates in to out. Return the number of dates adjusted.
+	// If the dates span fewer days than there are dates, cal is compiled over
+	// their range first: that calls it no more often than adjusting each date.
+	inline size_t adjust(std::span<const serial> in, std::span<serial> out, roll convention, const calendar& cal, unsigned threads = 1)
+	{
+		const size_t n = std::min(in.size(), out.size());
+		if (convention != roll::none and n > 0) {
+			const auto [lo, hi] = std::minmax_element(in.data(), in.data() + n);
+			if ((size_t)(*hi - *lo).count() < n) {
+				// rolls past the range use cal as the fallback
+				const compiled_calendar c(cal, *lo, *hi + serial::duration(1));
+				adjust_n(in.data(), n, out.data(), convention, c, threads);
+
+				return n;
+			}
+		}
+		adjust_n(in.data(), n, out.data(), convention, cal, threads);
+
+		return n;
+	}
+	inline size_t adjust(std::span<const serial> in, std::span<serial> out, roll convention, const compiled_calendar& cal, unsigned threads = 1)
+	{
+		const size_t n = std::min(in.size(), out.size());
+		adjust_n(in.data(), n, out.data(), convention, cal, threads);
+
+		return n;
+	}
+	inline size_t adjust(std::span<const serial> in, std::span<serial> out, roll convention, const roll_table& table, unsigned threads = 1)
+	{
+		const size_t n = std::min(in.size(), out.size());
+		adjust_n(in.data(), n, out.data(), convention, table, threads);
+
+		return n;
+	}
+
+#ifdef _DEBUG
+	inline int calendar_test()
+	{
+		{
+			compiled_calendar c;
+			assert(c.begin() == c.end());
+			assert(c.rank(c.begin()) == 0);
+			assert(c.business_days(make_serial(2023, 10, 1), make_serial(2023, 10, 8)) == 5);
+			assert(c.is_business_day(make_serial(2023, 10, 2)));
+			assert(!c.is_business_day(make_serial(2023, 10, 1)));
+		}
+		{
+			const auto from = make_serial(2000, 1, 1);
+			const auto to = make_serial(2030, 1, 1);
+			const compiled_calendar c(calendars::example, from, to);
+			assert(c.begin() <= from and c.begin() + serial::duration(64) > from);
+			assert(c.end() >= to and c.end() - serial::duration(64) < to);
+			assert(!c.contains(c.end()));
+
+			// agrees with the predicate in and out of range
+			for (auto s = c.begin() - serial::duration(100); s < c.end() + serial::duration(100); s += serial::duration(1)) {
+				assert(c.is_business_day(s) == !calendars::example(to_ymd(s)));
+				assert(c(to_ymd(s)) == calendars::example(to_ymd(s)));
+			}
+			for ([[maybe_unused]] auto r : { roll::none, roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+				for (auto s = from; s < make_serial(2002, 1, 1); s += serial::duration(1)) {
+					assert(adjust(s, r, c) == adjust(s, r, calendars::example));
+					assert(adjust(to_ymd(s), r, c) == adjust(to_ymd(s), r, calendars::example));
+				}
+			}
+			static_assert(business_days(make_serial(2023, 12, 29), make_serial(2024, 1, 3), calendars::example) == 2);
+			const auto d0 = make_serial(2001, 12, 20);
+			for (auto d1 = d0 - serial::duration(40); d1 < d0 + serial::duration(40); d1 += serial::duration(1)) {
+				assert(business_days(d0, d1, c) == business_days(d0, d1, calendars::example));
+			}
+			// partly or wholly out of range
+			for ([[maybe_unused]] auto d : { c.begin() - serial::duration(10), c.begin() + serial::duration(1), c.end() - serial::duration(3), c.end() + serial::duration(5) }) {
+				for ([[maybe_unused]] auto e : { c.begin() - serial::duration(3), c.begin() + serial::duration(100), c.end() - serial::duration(90), c.end() + serial::duration(9) }) {
+					assert(business_days(d, e, c) == business_days(d, e, calendars::example));
+				}
+			}
+			assert(c.rank(c.begin()) == 0);
+			assert(c.rank(c.end()) == business_days(c.begin(), c.end(), calendars::example));
+
+			static_assert(add_business_days(make_serial(2023, 12, 29), 1, calendars::example) == make_serial(2024, 1, 2));
+			static_assert(add_business_days(make_serial(2024, 1, 2), -1, calendars::example) == make_serial(2023, 12, 29));
+			static_assert(add_business_days(make_serial(2023, 12, 30), 0, calendars::example) == make_serial(2023, 12, 30));
+			for ([[maybe_unused]] int n : { 0, 1, 2, 5, -1, -2, -7, 260, -260, 2500, -2500 }) {
+				for (auto s = d0; s < d0 + serial::duration(10); s += serial::duration(1)) {
+					assert(add_business_days(s, n, c) == add_business_days(s, n, calendars::example));
+				}
+			}
+			// ends of the range
+			for ([[maybe_unused]] int n : { 1, 3, 100, -1, -3, -100 }) {
+				for ([[maybe_unused]] auto d : { c.begin() - serial::duration(1), c.begin(), c.begin() + serial::duration(2), c.end() - serial::duration(2), c.end(), c.end() + serial::duration(1) }) {
+					assert(add_business_days(d, n, c) == add_business_days(d, n, calendars::example));
+				}
+			}
+			// scans crossing words and the ends of the range
+			for (auto s : { c.begin(), c.begin() + serial::duration(63), c.begin() + serial::duration(64), c.end() - serial::duration(1), c.end() }) {
+				for ([[maybe_unused]] auto r : { roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+					for (auto t = s - serial::duration(5); t < s + serial::duration(5); t += serial::duration(1)) {
+						assert(adjust(t, r, c) == adjust(t, r, calendars::example));
+					}
+				}
+			}
+			for (int32_t k = 0; k < 200; ++k) {
+				[[maybe_unused]] const auto s = c.select(k);
+				assert(c.is_business_day(s) and c.rank(s) == k);
+			}
+		}
+
+		{
+			const compiled_calendar c(calendars::example, make_serial(2000, 1, 1), make_serial(2030, 1, 1));
+			std::vector<serial> in;
+			for (auto s = make_serial(1999, 12, 1); s < make_serial(2030, 2, 1); s += serial::duration(1)) {
+				in.push_back(s);
+			}
+			std::vector<serial> out(in.size()), out_(in.size());
+			for (auto r : { roll::none, roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+				[[maybe_unused]] size_t n = adjust(in, out, r, calendars::example);
+				assert(n == in.size());
+				for (size_t i = 0; i < in.size(); ++i) {
+					assert(out[i] == adjust(in[i], r, calendars::example));
+				}
+				for (unsigned threads : { 1u, 3u, 8u }) {
+					n = adjust(in, out_, r, c, threads);
+					assert(n == in.size());
+					assert(out_ == out);
+				}
+			}
+			[[maybe_unused]] size_t n = adjust(in, std::span(out.data(), 2), roll::following, c, 4);
+			assert(n == 2);
+
+			// too sparse to compile
+			const serial sparse[] = { make_serial(1999, 12, 31), make_serial(2024, 12, 31), make_serial(2023, 1, 1) };
+			n = adjust(sparse, out, roll::modified_following, calendars::example);
+			assert(n == 3);
+			for (size_t i = 0; i < 3; ++i) {
+				assert(out[i] == adjust(sparse[i], roll::modified_following, calendars::example));
+			}
+		}
+		{
+			const compiled_calendar c(calendars::example, make_serial(2000, 1, 1), make_serial(2030, 1, 1));
+			const roll_table t(c);
+			assert(t.bytes() == 4 * (size_t)(c.end() - c.begin()).count());
+			for ([[maybe_unused]] auto r : { roll::none, roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+				for (auto s = c.begin() - serial::duration(10); s < c.end() + serial::duration(10); s += serial::duration(1)) {
+					assert(adjust(s, r, t) == adjust(s, r, c));
+				}
+			}
+		}
+		{
+			auto c = compiled_calendar(calendars::weekday, make_serial(2023, 1, 1), make_serial(2024, 1, 1), calendars::example);
+			assert(c.is_business_day(make_serial(2023, 1, 2)));
+			assert(!c.is_business_day(make_serial(2025, 1, 1))); // fallback
+			const serial closed[] = { make_serial(2023, 1, 2), make_serial(2023, 1, 1), make_serial(2000, 1, 3) };
+			c.close(closed);
+			assert(!c.is_business_day(make_serial(2023, 1, 2)));
+			assert(c.is_business_day(make_serial(2000, 1, 3)));
+			assert(c.business_days(make_serial(2023, 1, 1), make_serial(2023, 1, 9)) == 4);
+		}
+		{
+			// weekend masks agree with the predicate in and out of range
+			for (const auto& w : { calendars::saturday_sunday, calendars::friday_saturday, calendars::friday, calendars::weekend{ 0 }, calendars::weekend{ 127 } }) {
+				const compiled_calendar c(w, make_serial(1899, 12, 30), make_serial(2001, 1, 1));
+				assert(c.begin() < make_serial(1900, 1, 1));
+				for (auto s = c.begin() - serial::duration(10); s < c.end() + serial::duration(10); s += serial::duration(1)) {
+					assert(c.is_business_day(s) == !w(to_ymd(s)));
+				}
+				assert(calendar(w) == calendars::weekends[w.mask]);
+			}
+			const compiled_calendar c(calendars::saturday_sunday, make_serial(2000, 1, 1), make_serial(2030, 1, 1));
+			const compiled_calendar d(calendars::weekday, make_serial(2000, 1, 1), make_serial(2030, 1, 1));
+			assert(std::ranges::equal(c.words(), d.words()));
+			assert(std::ranges::equal(c.prefix_counts(), d.prefix_counts()));
+		}
+		{
+			// closures longer than a word
+			constexpr calendar august = [](const ymd& d) { return calendars::weekday(d) or d.month() == std::chrono::August; };
+			const compiled_calendar c(august, make_serial(2020, 1, 1), make_serial(2025, 1, 1));
+			for ([[maybe_unused]] auto r : { roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+				for (auto s = make_serial(2023, 7, 25); s < make_serial(2023, 9, 5); s += serial::duration(1)) {
+					assert(adjust(s, r, c) == adjust(s, r, august));
+				}
+			}
+			// offsets that do not fit in 8 bits
+			constexpr calendar summer = [](const ymd& d) { return calendars::weekday(d) or (d.month() >= std::chrono::June and d.month() <= std::chrono::October); };
+			const compiled_calendar cs(summer, make_serial(2020, 1, 1), make_serial(2025, 1, 1));
+			const roll_table t(cs);
+			for ([[maybe_unused]] auto r : { roll::following, roll::previous, roll::modified_following, roll::modified_previous }) {
+				for (auto s = make_serial(2023, 5, 25); s < make_serial(2023, 11, 5); s += serial::duration(1)) {
+					assert(adjust(s, r, t) == adjust(s, r, summer));
+				}
+			}
+		}
+		{
+			constexpr calendar august = [](const ymd& d) { return calendars::weekday(d) or d.month() == std::chrono::August; };
+			const compiled_calendar a(calendars::example, make_serial(2020, 1, 1), make_serial(2025, 1, 1));
+			const compiled_calendar b(august, make_serial(2020, 1, 1), make_serial(2025, 1, 1));
+			const compiled_calendar b2(august, make_serial(2022, 3, 1), make_serial(2027, 1, 1));
+			const auto u = a | b;
+			const auto u2 = a | b2;
+			const auto i = a & b;
+			const auto m = b - a;
+			assert(u2.begin() == a.begin() and u2.end() == b2.end());
+			for (auto s = make_serial(2019, 6, 1); s < make_serial(2027, 6, 1); s += serial::duration(1)) {
+				[[maybe_unused]] const bool ha = !a.is_business_day(s);
+				[[maybe_unused]] const bool hb = !b.is_business_day(s);
+				if (u.contains(s)) {
+					assert(u.is_business_day(s) == !(ha or hb));
+					assert(i.is_business_day(s) == !(ha and hb));
+					assert(m.is_business_day(s) == !(hb and !ha));
+				}
+				if (u2.contains(s)) {
+					assert(u2.is_business_day(s) == !(ha or hb));
+				}
+			}
+			assert(u.business_days(make_serial(2023, 7, 31), make_serial(2023, 9, 5)) == 3);
+
+			// empty operands contribute their weekday fallback
+			const compiled_calendar e;
+			const auto em = e - b;
+			const auto be = b & e;
+			const auto bu = b | e;
+			assert(em.begin() == b.begin() and em.end() == b.end());
+			assert(be.begin() == b.begin() and bu.end() == b.end());
+			for (auto s = b.begin(); s < b.end(); s += serial::duration(1)) {
+				[[maybe_unused]] const bool he = calendars::weekday(to_ymd(s));
+				[[maybe_unused]] const bool hb = !b.is_business_day(s);
+				assert(em.is_business_day(s) == !(he and !hb));
+				assert(be.is_business_day(s) == !(hb and he));
+				assert(bu.is_business_day(s) == b.is_business_day(s));
+			}
+			assert(be.business_days(make_serial(2023, 7, 31), make_serial(2023, 9, 5)) == 26);
+			assert((e | e).words().empty());
+
+			joint_calendars joint;
+			[[maybe_unused]] const auto& ab = joint({ &a, &b });
+			[[maybe_unused]] const auto& ba = joint({ &b, &a });
+			[[maybe_unused]] const auto& bab = joint({ &b, &a, &b });
+			assert(&ba == &ab and &bab == &ab);
+			assert(joint.size() == 1);
+			assert(ab.business_days(u.begin(), u.end()) == u.business_days(u.begin(), u.end()));
+			joint({ &a });
+			assert(joint.size() == 2);
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
@@ -0,0 +1,314 @@
+// fms_date_calendar_file.h - Compiled calendars stored in memory mapped files
+#pragma once
+#include <bit>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "fms_date_calendar.h"
+#include "fms_date_text.h"
+
+namespace fms::date {
+
+	// Calendar file layout in native byte order:
+	// header, words business day words, words + 1 prefix counts.
+	// The words start 8 byte aligned so a mapping is used in place.
+	struct calendar_file_header {
+		char magic[4] = { 'F', 'M', 'S', 'C' };
+		uint32_t order = 0x01020304; // byte order of the writer
+		uint32_t version = 1;
+		int32_t first = 0; // serial date of bit 0
+		uint32_t words = 0;
+		uint32_t reserved[3] = {};
+
+		// Size of the file described by the header.
+		constexpr size_t bytes() const
+		{
+			return sizeof(calendar_file_header) + words * sizeof(uint64_t) + (words + 1) * sizeof(uint32_t);
+		}
+		// Written by this library on a machine with the same byte order.
+		bool ok() const
+		{
+			const calendar_file_header h;
+
+			return std::memcmp(magic, h.magic, sizeof(magic)) == 0 and order == h.order and version == h.version;
+		}
+	};
+	static_assert(sizeof(calendar_file_header) == 32);
+
+	// Write the words and prefix counts of cal to path. Return false on failure.
+	// The file is written next to path and renamed over it, so processes that
+	// have the old file mapped keep using it intact.
+	inline bool write(const compiled_calendar& cal, const char* path)
+	{
+		calendar_file_header h;
+		h.first = cal.begin().time_since_epoch().count();
+		h.words = (uint32_t)cal.words().size();
+
+		const std::string tmp = std::string(path) + ".tmp";
+		FILE* fp = std::fopen(tmp.c_str(), "wb");
+		if (!fp) {
+			return false;
+		}
+		bool ok = std::fwrite(&h, sizeof(h), 1, fp) == 1;
+		ok = ok and std::fwrite(cal.words().data(), sizeof(uint64_t), h.words, fp) == h.words;
+		ok = ok and std::fwrite(cal.prefix_counts().data(), sizeof(uint32_t), h.words + 1, fp) == h.words + 1;
+		ok = std::fclose(fp) == 0 and ok;
+#ifdef _WIN32
+		ok = ok and MoveFileExA(tmp.c_str(), path, MOVEFILE_REPLACE_EXISTING);
+#else
+		ok = ok and std::rename(tmp.c_str(), path) == 0;
+#endif
+		if (!ok) {
+			std::remove(tmp.c_str());
+		}
+
+		return ok;
+	}
+
+	// Read only mapping of a whole file unmapped when the last copy goes away.
+	class mapped_file {
+		const void* p = nullptr;
+		size_t n = 0;
+	public:
+		explicit mapped_file(const char* path)
+		{
+#ifdef _WIN32
+			HANDLE f = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (f == INVALID_HANDLE_VALUE) {
+				return;
+			}
+			LARGE_INTEGER size;
+			if (GetFileSizeEx(f, &size) and size.QuadPart > 0) {
+				HANDLE m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+				if (m) {
+					p = MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+					n = p ? (size_t)size.QuadPart : 0;
+					CloseHandle(m);
+				}
+			}
+			CloseHandle(f);
+#else
+			const int fd = ::open(path, O_RDONLY);
+			if (fd == -1) {
+				return;
+			}
+			struct stat st;
+			if (::fstat(fd, &st) == 0 and st.st_size > 0) {
+				void* q = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				if (q != MAP_FAILED) {
+					p = q;
+					n = (size_t)st.st_size;
+				}
+			}
+			::close(fd);
+#endif
+		}
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+		~mapped_file()
+		{
+			if (p) {
+#ifdef _WIN32
+				UnmapViewOfFile(p);
+#else
+				::munmap(const_cast<void*>(p), n);
+#endif
+			}
+		}
+
+		const void* data() const
+		{
+			return p;
+		}
+		size_t size() const
+		{
+			return n;
+		}
+	};
+
+	// Calendar using the words of a calendar file in place.
+	// Dates outside the range use fallback. Empty if the file is missing or malformed,
+	// including prefix counts that do not match the words.
+	inline std::optional<compiled_calendar> map_calendar(const char* path, const calendar& fallback = calendars::weekday)
+	{
+		auto file = std::make_shared<const mapped_file>(path);
+		if (file->size() < sizeof(calendar_file_header)) {
+			return std::nullopt;
+		}
+
+		const auto p = static_cast<const char*>(file->data());
+		const auto& h = *reinterpret_cast<const calendar_file_header*>(p);
+		if (!h.ok() or h.first % 64 != 0 or h.words > (uint32_t)std::numeric_limits<int32_t>::max() / 64 or file->size() != h.bytes()) {
+			return std::nullopt;
+		}
+		const auto bits = reinterpret_cast<const uint64_t*>(p + sizeof(h));
+		const auto ranks = reinterpret_cast<const uint32_t*>(bits + h.words);
+		if (ranks[0] != 0) {
+			return std::nullopt;
+		}
+		for (uint32_t w = 0; w < h.words; ++w) {
+			if (ranks[w + 1] != ranks[w] + (uint32_t)std::popcount(bits[w])) {
+				return std::nullopt;
+			}
+		}
+
+		return compiled_calendar(std::move(file), h.first, (int32_t)h.words, bits, ranks, fallback);
+	}
+
+	// Holiday dates in the first field of each line of CSV text as YYYY-MM-DD or YYYYMMDD.
+	// Lines that do not start with a date, such as headers, are skipped.
+	inline std::vector<serial> read_holidays(std::string_view csv)
+	{
+		std::vector<serial> s;
+		while (!csv.empty()) {
+			auto line = csv.substr(0, csv.find('\n'));
+			csv.remove_prefix(std::min(line.size() + 1, csv.size()));
+			line = line.substr(0, line.find_first_of(",\r"));
+			while (!line.empty() and (line.front() == ' ' or line.front() == '"')) {
+				line.remove_prefix(1);
+			}
+			while (!line.empty() and (line.back() == ' ' or line.back() == '"')) {
+				line.remove_suffix(1);
+			}
+
+			if (serial d; parse_date(line, d)) {
+				s.push_back(d);
+			}
+		}
+
+		return s;
+	}
+
+	// Convert a CSV list of holidays to a calendar file of weekends and holidays over [from, to).
+	inline bool convert_holidays(const char* csv_path, const char* path,
+		serial from = make_serial(1900, 1, 1), serial to = make_serial(2201, 1, 1), const calendars::weekend& weekend = calendars::saturday_sunday)
+	{
+		std::string text;
+		FILE* fp = std::fopen(csv_path, "rb");
+		if (!fp) {
+			return false;
+		}
+		char buf[1 << 12];
+		for (size_t n; (n = std::fread(buf, 1, sizeof(buf), fp)) > 0;) {
+			text.append(buf, n);
+		}
+		std::fclose(fp);
+
+		const auto holidays = read_holidays(text);
+
+		return write(compiled_calendar(weekend, from, to).close(holidays), path);
+	}
+
+#ifdef _DEBUG
+	inline int calendar_file_test()
+	{
+		{
+			const auto h = read_holidays("date,name\n2023-12-25,Christmas\r\n20240101\n\n \"2024-07-04\" ,x\n2023-02-30\nbad\n");
+			assert(h.size() == 3);
+			assert(h[0] == make_serial(2023, 12, 25));
+			assert(h[1] == make_serial(2024, 1, 1));
+			assert(h[2] == make_serial(2024, 7, 4));
+		}
+		const auto tmp = std::filesystem::temp_directory_path();
+		const auto cal_path = (tmp / "fms_date_calendar_file_test.cal").string();
+		const auto csv_path = (tmp / "fms_date_calendar_file_test.csv").string();
+		{
+			const char* path = cal_path.c_str();
+			const compiled_calendar c(calendars::example, make_serial(2000, 1, 1), make_serial(2030, 1, 1));
+			[[maybe_unused]] const bool written = write(c, path);
+			assert(written);
+			{
+				const auto m = map_calendar(path, calendars::example);
+				assert(m);
+				assert(m->begin() == c.begin() and m->end() == c.end());
+				assert(std::ranges::equal(m->prefix_counts(), c.prefix_counts()));
+				const auto copy = *m; // shares the mapping
+				for (auto s = c.begin() - serial::duration(10); s < c.end() + serial::duration(10); s += serial::duration(1)) {
+					assert(copy.is_business_day(s) == c.is_business_day(s));
+					assert(adjust(s, roll::modified_following, *m) == adjust(s, roll::modified_following, c));
+				}
+				assert(m->business_days(make_serial(2023, 12, 29), make_serial(2024, 1, 3)) == 2);
+
+				// replacing the file leaves the mapping intact
+				const compiled_calendar small(calendars::weekday, make_serial(2024, 1, 1), make_serial(2024, 2, 1));
+				[[maybe_unused]] const bool replaced = write(small, path);
+				assert(replaced);
+				assert(m->business_days(c.begin(), c.end()) == c.business_days(c.begin(), c.end()));
+				const auto m2 = map_calendar(path);
+				assert(m2 and m2->end() == small.end());
+				[[maybe_unused]] const bool restored = write(c, path);
+				assert(restored);
+			}
+			{
+				// prefix counts must match the words
+				const calendar_file_header h;
+				FILE* fp = std::fopen(path, "r+b");
+				assert(fp);
+				if (fp) {
+					const uint32_t bad = 1;
+					[[maybe_unused]] const int s = std::fseek(fp, (long)(sizeof(h) + c.words().size() * sizeof(uint64_t)), SEEK_SET);
+					[[maybe_unused]] const size_t w = std::fwrite(&bad, sizeof(bad), 1, fp);
+					[[maybe_unused]] const int e = std::fclose(fp);
+					assert(s == 0 and w == 1 and e == 0);
+					assert(!map_calendar(path));
+				}
+				[[maybe_unused]] const bool restored = write(c, path);
+				assert(restored);
+			}
+			assert(!map_calendar((tmp / "fms_date_calendar_file_test.missing").string().c_str()));
+
+			FILE* fp = std::fopen(path, "r+b");
+			assert(fp);
+			if (fp) {
+				[[maybe_unused]] const int c = std::fputc('X', fp); // bad magic
+				[[maybe_unused]] const int e = std::fclose(fp);
+				assert(c == 'X' and e == 0);
+				assert(!map_calendar(path));
+			}
+			std::remove(path);
+		}
+		{
+			const char* csv = csv_path.c_str();
+			const char* path = cal_path.c_str();
+			FILE* fp = std::fopen(csv, "w");
+			assert(fp);
+			if (fp) {
+				[[maybe_unused]] const int c = std::fputs("2024-01-01\n2024-12-25\n", fp);
+				[[maybe_unused]] const int e = std::fclose(fp);
+				assert(c >= 0 and e == 0);
+			}
+			[[maybe_unused]] const bool missing = convert_holidays((tmp / "fms_date_calendar_file_test.missing").string().c_str(), path);
+			assert(!missing);
+			[[maybe_unused]] const bool converted = convert_holidays(csv, path, make_serial(2024, 1, 1), make_serial(2025, 1, 1));
+			assert(converted);
+			const auto m = map_calendar(path);
+			assert(m);
+			assert(!m->is_business_day(make_serial(2024, 1, 1)));
+			assert(!m->is_business_day(make_serial(2024, 12, 25)));
+			assert(m->is_business_day(make_serial(2024, 1, 2)));
+			assert(m->business_days(make_serial(2024, 1, 1), make_serial(2024, 1, 8)) == 4);
+			std::remove(csv);
+			std::remove(path);
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
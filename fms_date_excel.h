@@ -0,0 +1,179 @@
+// fms_date_excel.h - Excel serial numbers
+#pragma once
+#include <limits>
+#include <span>
+#include <vector>
+#include "fms_date_batch.h"
+
+namespace fms::date {
+
+	// Excel date systems.
+	enum class excel_system {
+		_1900, // 1 is 1900-01-01 and 60 is the nonexistent 1900-02-29
+		_1904, // 0 is 1904-01-01
+	};
+
+	namespace excel {
+
+		// Excel serial number of 1970-01-01.
+		constexpr int32_t epoch(excel_system e)
+		{
+			return e == excel_system::_1904 ? 24107 : 25569;
+		}
+		// Excel serial number of 1900-03-01, the first day after the phantom leap day.
+		constexpr int32_t march_1900 = 61;
+
+		// Days since 1970-01-01 of a whole Excel serial number.
+		// In the 1900 system days before March 1900 are off by one and 60 is 1900-02-28.
+		constexpr int32_t days(int32_t x, excel_system e)
+		{
+			return x - epoch(e) + (e == excel_system::_1900 and x < march_1900 - 1);
+		}
+		// Excel serial number of days since 1970-01-01.
+		constexpr int32_t serial_number(int32_t n, excel_system e)
+		{
+			return n + epoch(e) - (e == excel_system::_1900 and n < march_1900 - epoch(e));
+		}
+		// Bound on serial numbers so NaN, infinities, and huge values convert without overflow.
+		constexpr double limit = 1 << 30;
+		// Largest integer not greater than x clamped to [-limit, limit] without a library call.
+		// NaN is -limit. The comparisons are min and max instructions, not branches.
+		constexpr int32_t floor(double x)
+		{
+			x = x > -limit ? x : -limit;
+			x = x < limit ? x : limit;
+			const auto i = static_cast<int32_t>(x);
+
+			return i - (x < i);
+		}
+
+	} // namespace excel
+
+	// Date of an Excel serial number. The fraction of a day is dropped.
+	// Serial numbers outside [-excel::limit, excel::limit] and NaN are clamped.
+	constexpr serial from_excel(double x, excel_system e = excel_system::_1900)
+	{
+		return serial(serial::duration(excel::days(excel::floor(x), e)));
+	}
+	// Excel serial number of a date.
+	constexpr double to_excel(const serial& s, excel_system e = excel_system::_1900)
+	{
+		return excel::serial_number(s.time_since_epoch().count(), e);
+	}
+	constexpr double to_excel(const ymd& d, excel_system e = excel_system::_1900)
+	{
+		return excel::serial_number(days_from_civil(d), e);
+	}
+
+	// Convert Excel serial numbers to dates. Return the number of dates converted.
+	// The system is dispatched outside the loop and the body is branch free.
+	// Every input converts: NaN, infinities, and huge values are clamped as in from_excel.
+	inline size_t from_excel(std::span<const double> x, std::span<serial> s, excel_system e = excel_system::_1900)
+	{
+		const size_t n = std::min(x.size(), s.size());
+		const double* px = x.data();
+		serial* ps = s.data();
+		if (e == excel_system::_1900) {
+			for (size_t i = 0; i < n; ++i) {
+				ps[i] = serial(serial::duration(excel::days(excel::floor(px[i]), excel_system::_1900)));
+			}
+		}
+		else {
+			for (size_t i = 0; i < n; ++i) {
+				ps[i] = serial(serial::duration(excel::days(excel::floor(px[i]), excel_system::_1904)));
+			}
+		}
+
+		return n;
+	}
+	// Convert dates to Excel serial numbers. Return the number of dates converted.
+	inline size_t to_excel(std::span<const serial> s, std::span<double> x, excel_system e = excel_system::_1900)
+	{
+		const size_t n = std::min(s.size(), x.size());
+		const serial* ps = s.data();
+		double* px = x.data();
+		if (e == excel_system::_1900) {
+			for (size_t i = 0; i < n; ++i) {
+				px[i] = excel::serial_number(ps[i].time_since_epoch().count(), excel_system::_1900);
+			}
+		}
+		else {
+			for (size_t i = 0; i < n; ++i) {
+				px[i] = excel::serial_number(ps[i].time_since_epoch().count(), excel_system::_1904);
+			}
+		}
+
+		return n;
+	}
+
+#ifdef _DEBUG
+	inline int excel_test()
+	{
+		{
+			static_assert(from_excel(1) == make_serial(1900, 1, 1));
+			static_assert(from_excel(59) == make_serial(1900, 2, 28));
+			static_assert(from_excel(60) == make_serial(1900, 2, 28)); // phantom 1900-02-29
+			static_assert(from_excel(61) == make_serial(1900, 3, 1));
+			static_assert(from_excel(25569) == make_serial(1970, 1, 1));
+			static_assert(from_excel(45021.75) == make_serial(2023, 4, 5));
+			static_assert(from_excel(0, excel_system::_1904) == make_serial(1904, 1, 1));
+			static_assert(from_excel(43559.5, excel_system::_1904) == make_serial(2023, 4, 5));
+			static_assert(from_excel(-0.5, excel_system::_1904) == make_serial(1903, 12, 31));
+
+			constexpr double inf = std::numeric_limits<double>::infinity();
+			constexpr double nan = std::numeric_limits<double>::quiet_NaN();
+			static_assert(excel::floor(inf) == excel::limit);
+			static_assert(excel::floor(1e300) == excel::limit);
+			static_assert(excel::floor(-inf) == -excel::limit);
+			static_assert(excel::floor(nan) == -excel::limit);
+			static_assert(excel::floor(-1e10) == -excel::limit);
+			static_assert(excel::floor(-2.5) == -3);
+			static_assert(from_excel(inf) == from_excel(excel::limit));
+
+			static_assert(to_excel(make_serial(1900, 1, 1)) == 1);
+			static_assert(to_excel(make_serial(1900, 2, 28)) == 59);
+			static_assert(to_excel(make_serial(1900, 3, 1)) == 61);
+			static_assert(to_excel(make_ymd(2023, 4, 5)) == 45021);
+			static_assert(to_excel(make_ymd(2023, 4, 5), excel_system::_1904) == 45021 - 1462);
+			static_assert(to_excel(make_serial(1904, 1, 1), excel_system::_1904) == 0);
+		}
+		{
+			// round trip and agreement with counting days from 1899-12-31
+			std::vector<serial> s;
+			for (auto t = make_serial(1900, 1, 1); t < make_serial(2201, 1, 1); t += serial::duration(1)) {
+				s.push_back(t);
+			}
+			for ([[maybe_unused]] auto e : { excel_system::_1900, excel_system::_1904 }) {
+				std::vector<double> x(s.size());
+				std::vector<serial> s_(s.size());
+				[[maybe_unused]] size_t n = to_excel(s, x, e);
+				assert(n == s.size());
+				for (size_t i = 0; i < s.size(); ++i) {
+					assert(x[i] == to_excel(s[i], e));
+					x[i] += 0.25; // time of day
+				}
+				n = from_excel(x, s_, e);
+				assert(n == s.size());
+				assert(s_ == s);
+			}
+			for (size_t i = 0; i < s.size(); ++i) {
+				[[maybe_unused]] const double x = (double)(s[i] - make_serial(1899, 12, 31)).count();
+				assert(to_excel(s[i]) == x + (s[i] >= make_serial(1900, 3, 1)));
+			}
+			const double x[] = { 1, 60, 61 };
+			serial t[3];
+			[[maybe_unused]] size_t n = from_excel(x, std::span(t, 2));
+			assert(n == 2);
+
+			const double y[] = { std::numeric_limits<double>::quiet_NaN(), -std::numeric_limits<double>::infinity(), 1e20 };
+			n = from_excel(y, t);
+			assert(n == 3);
+			assert(t[0] == from_excel(-excel::limit) and t[1] == t[0]);
+			assert(t[2] == from_excel(excel::limit));
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
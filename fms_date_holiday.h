@@ -0,0 +1,380 @@
+// fms_date_holiday.h - Rule based holidays and exchange calendars
+#pragma once
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+#include "fms_date_calendar.h"
+
+namespace fms::date {
+
+	namespace holidays {
+
+		// Easter Sunday in the Gregorian calendar.
+		// https://en.wikipedia.org/wiki/Date_of_Easter#Anonymous_Gregorian_algorithm
+		constexpr ymd easter(std::chrono::year y)
+		{
+			const int Y = (int)y;
+			const int a = Y % 19;
+			const int b = Y / 100;
+			const int c = Y % 100;
+			const int d = b / 4;
+			const int e = b % 4;
+			const int f = (b + 8) / 25;
+			const int g = (b - f + 1) / 3;
+			const int h = (19 * a + b - d - g + 15) % 30;
+			const int i = c / 4;
+			const int k = c % 4;
+			const int l = (32 + 2 * e + 2 * i - h - k) % 7;
+			const int m = (a + 11 * h + 22 * l) / 451;
+			const int n = h + l - 7 * m + 114;
+
+			return make_ymd(Y, n / 31, n % 31 + 1);
+		}
+
+		// Day of the year of Easter Sunday for years in [Y0, Y1].
+		// Easter falls between March 22 and April 25 so the day of the year fits in a byte.
+		template<int Y0 = 1900, int Y1 = 2200>
+		class easter_table {
+			static constexpr int N = Y1 - Y0 + 1;
+			std::array<uint8_t, N> doy; // 1 is January 1
+		public:
+			constexpr easter_table()
+				: doy{}
+			{
+				for (int i = 0; i < N; ++i) {
+					const auto y = std::chrono::year(Y0 + i);
+					doy[i] = (uint8_t)((sys_days(easter(y)) - sys_days(y / 1 / 1)).count() + 1);
+				}
+			}
+
+			constexpr bool contains(std::chrono::year y) const
+			{
+				return std::chrono::year(Y0) <= y and y <= std::chrono::year(Y1);
+			}
+			// Day of the year of Easter Sunday.
+			constexpr unsigned day_of_year(std::chrono::year y) const
+			{
+				if (!contains(y)) {
+					return (unsigned)((sys_days(easter(y)) - sys_days(y / 1 / 1)).count() + 1);
+				}
+
+				return doy[(int)y - Y0];
+			}
+			// Easter Sunday using the table in range and the computus otherwise.
+			constexpr sys_days operator()(std::chrono::year y) const
+			{
+				return sys_days(y / 1 / 1) + std::chrono::days(day_of_year(y) - 1);
+			}
+		};
+		inline constexpr easter_table<> easter_days;
+
+		// How a holiday falling on a weekend is observed.
+		enum class observed {
+			none,    // not moved
+			nearest, // Saturday to Friday, Sunday to Monday
+			sunday,  // Sunday to Monday, Saturday not observed
+		};
+
+		enum class rule_type {
+			fixed,        // month and day
+			nth_weekday,  // n-th weekday of month
+			last_weekday, // last weekday of month
+			easter,       // days from Easter Sunday
+		};
+
+		// Yearly holiday in effect for years in [first_year, last_year].
+		struct rule {
+			rule_type type;
+			std::chrono::month month;
+			unsigned n; // day of month or weekday index
+			std::chrono::weekday weekday;
+			int offset; // days from Easter Sunday
+			observed observance;
+			int first_year, last_year;
+
+			// Observed date of the holiday for year y, not ok() if not in effect.
+			constexpr ymd date(std::chrono::year y) const
+			{
+				if (y < std::chrono::year(first_year) or y > std::chrono::year(last_year)) {
+					return ymd{};
+				}
+
+				sys_days d;
+				switch (type) {
+				case rule_type::fixed:
+					d = sys_days(y / month / std::chrono::day(n));
+					break;
+				case rule_type::nth_weekday:
+					d = sys_days(y / month / weekday[n]);
+					break;
+				case rule_type::last_weekday:
+					d = sys_days(y / month / weekday[std::chrono::last]);
+					break;
+				case rule_type::easter:
+					d = easter_days(y) + std::chrono::days(offset);
+					break;
+				default:
+					return ymd{};
+				}
+
+				const auto wd = std::chrono::weekday(d);
+				if (wd == std::chrono::Saturday and observance == observed::nearest) {
+					d -= std::chrono::days(1);
+				}
+				else if (wd == std::chrono::Sunday and observance != observed::none) {
+					d += std::chrono::days(1);
+				}
+
+				return ymd(d);
+			}
+			// Holiday on d.
+			constexpr bool operator()(const ymd& d) const
+			{
+				// observance can move a holiday into an adjacent year
+				return date(d.year()) == d or date(d.year() + std::chrono::years(1)) == d or date(d.year() - std::chrono::years(1)) == d;
+			}
+
+			// Same rule in effect only for years in [first, last].
+			constexpr rule years(int first, int last) const
+			{
+				rule r = *this;
+				r.first_year = first;
+				r.last_year = last;
+
+				return r;
+			}
+		};
+
+		constexpr rule fixed(std::chrono::month m, std::chrono::day d, observed o = observed::none)
+		{
+			return rule{ rule_type::fixed, m, (unsigned)d, std::chrono::Sunday, 0, o, -32767, 32767 };
+		}
+		// Single closure.
+		constexpr rule once(const ymd& d)
+		{
+			return fixed(d.month(), d.day()).years((int)d.year(), (int)d.year());
+		}
+		constexpr rule nth_weekday(unsigned n, std::chrono::weekday wd, std::chrono::month m)
+		{
+			return rule{ rule_type::nth_weekday, m, n, wd, 0, observed::none, -32767, 32767 };
+		}
+		constexpr rule last_weekday(std::chrono::weekday wd, std::chrono::month m)
+		{
+			return rule{ rule_type::last_weekday, m, 0, wd, 0, observed::none, -32767, 32767 };
+		}
+		constexpr rule easter_offset(int days)
+		{
+			return rule{ rule_type::easter, std::chrono::month{}, 0, std::chrono::Sunday, days, observed::none, -32767, 32767 };
+		}
+
+		// True if d is a holiday of any rule. Evaluates every rule.
+		constexpr bool any(std::span<const rule> rules, const ymd& d)
+		{
+			for (const auto& r : rules) {
+				if (r(d)) {
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		// Serial dates of all holidays in years [from, to].
+		inline std::vector<serial> dates(std::span<const rule> rules, std::chrono::year from, std::chrono::year to)
+		{
+			std::vector<serial> s;
+			for (auto y = from; y <= to; ++y) {
+				for (const auto& r : rules) {
+					if (const auto d = r.date(y); d.ok()) {
+						s.push_back(to_serial(d));
+					}
+				}
+			}
+
+			return s;
+		}
+
+		using namespace std::chrono_literals;
+		using std::chrono::Monday, std::chrono::Thursday;
+
+		// New York Stock Exchange full day closures since 1998.
+		// https://www.nyse.com/markets/hours-calendars
+		inline constexpr rule nyse[] = {
+			fixed(std::chrono::January, 1d, observed::sunday),
+			nth_weekday(3, Monday, std::chrono::January).years(1998, 32767), // Martin Luther King Jr. Day
+			nth_weekday(3, Monday, std::chrono::February), // Washington's Birthday
+			easter_offset(-2), // Good Friday
+			last_weekday(Monday, std::chrono::May), // Memorial Day
+			fixed(std::chrono::June, 19d, observed::nearest).years(2022, 32767), // Juneteenth
+			fixed(std::chrono::July, 4d, observed::nearest),
+			nth_weekday(1, Monday, std::chrono::September), // Labor Day
+			nth_weekday(4, Thursday, std::chrono::November), // Thanksgiving
+			fixed(std::chrono::December, 25d, observed::nearest),
+			once(2001y / 9 / 11), once(2001y / 9 / 12), once(2001y / 9 / 13), once(2001y / 9 / 14),
+			once(2004y / 6 / 11), // Reagan
+			once(2007y / 1 / 2), // Ford
+			once(2012y / 10 / 29), once(2012y / 10 / 30), // Hurricane Sandy
+			once(2018y / 12 / 5), // G. H. W. Bush
+			once(2025y / 1 / 9), // Carter
+		};
+
+		// SIFMA recommended US bond market full day closures.
+		// https://www.sifma.org/resources/general/holiday-schedule/
+		inline constexpr rule sifma[] = {
+			fixed(std::chrono::January, 1d, observed::sunday),
+			nth_weekday(3, Monday, std::chrono::January),
+			nth_weekday(3, Monday, std::chrono::February),
+			easter_offset(-2),
+			last_weekday(Monday, std::chrono::May),
+			fixed(std::chrono::June, 19d, observed::nearest).years(2022, 32767),
+			fixed(std::chrono::July, 4d, observed::nearest),
+			nth_weekday(1, Monday, std::chrono::September),
+			nth_weekday(2, Monday, std::chrono::October), // Columbus Day
+			fixed(std::chrono::November, 11d, observed::sunday), // Veterans Day
+			nth_weekday(4, Thursday, std::chrono::November),
+			fixed(std::chrono::December, 25d, observed::nearest),
+		};
+
+		// Trans-European Automated Real-time Gross settlement Express Transfer system.
+		// https://www.ecb.europa.eu/paym/target/target2/profuse/calendar/html/index.en.html
+		inline constexpr rule target[] = {
+			fixed(std::chrono::January, 1d),
+			easter_offset(-2).years(2000, 32767), // Good Friday
+			easter_offset(1).years(2000, 32767), // Easter Monday
+			fixed(std::chrono::May, 1d).years(2000, 32767), // Labour Day
+			fixed(std::chrono::December, 25d),
+			fixed(std::chrono::December, 26d).years(2000, 32767),
+			fixed(std::chrono::December, 31d).years(1999, 2001),
+		};
+
+	} // namespace holidays
+
+	namespace calendars {
+
+		// Rule calendars evaluated per call. Use the compiled versions in hot paths.
+		constexpr bool nyse(const ymd& d)
+		{
+			return weekday(d) or holidays::any(holidays::nyse, d);
+		}
+		constexpr bool sifma(const ymd& d)
+		{
+			return weekday(d) or holidays::any(holidays::sifma, d);
+		}
+		constexpr bool target(const ymd& d)
+		{
+			return weekday(d) or holidays::any(holidays::target, d);
+		}
+
+	} // namespace calendars
+
+	// Compile weekends and holiday rules over [from, to) by marking the date of
+	// each rule in each year instead of evaluating rules for every day.
+	// Dates outside the range use the predicate cal.
+	inline compiled_calendar compile(std::span<const holidays::rule> rules, const calendar& cal,
+		serial from = make_serial(1900, 1, 1), serial to = make_serial(2201, 1, 1), const calendars::weekend& weekend = calendars::saturday_sunday)
+	{
+		auto c = compiled_calendar(weekend, from, to, cal);
+		const auto y0 = to_ymd(c.begin()).year() - std::chrono::years(1);
+		const auto y1 = to_ymd(c.end()).year() + std::chrono::years(1);
+
+		return c.close(holidays::dates(rules, y0, y1));
+	}
+
+	namespace calendars::compiled {
+
+		// Built once on first use.
+		inline const compiled_calendar& nyse()
+		{
+			static const compiled_calendar c = compile(holidays::nyse, calendars::nyse);
+
+			return c;
+		}
+		inline const compiled_calendar& sifma()
+		{
+			static const compiled_calendar c = compile(holidays::sifma, calendars::sifma);
+
+			return c;
+		}
+		inline const compiled_calendar& target()
+		{
+			static const compiled_calendar c = compile(holidays::target, calendars::target);
+
+			return c;
+		}
+
+	} // namespace calendars::compiled
+
+#ifdef _DEBUG
+	inline int holiday_test()
+	{
+		using namespace std::chrono_literals;
+		{
+			static_assert(holidays::easter(2023y) == 2023y / 4 / 9);
+			static_assert(holidays::easter(2024y) == 2024y / 3 / 31);
+			static_assert(holidays::easter(2000y) == 2000y / 4 / 23);
+			static_assert(holidays::easter(2285y) == 2285y / 3 / 22);
+			static_assert(holidays::easter(2038y) == 2038y / 4 / 25);
+			static_assert(holidays::easter_days.day_of_year(2023y) == 99);
+			static_assert(holidays::easter_days(2024y) == sys_days(2024y / 3 / 31));
+			static_assert(holidays::easter_days(2285y) == sys_days(2285y / 3 / 22));
+			for (int y = 1900; y <= 2200; ++y) {
+				assert(holidays::easter_days(std::chrono::year(y)) == sys_days(holidays::easter(std::chrono::year(y))));
+			}
+		}
+		{
+			constexpr auto r = holidays::fixed(std::chrono::July, 4d, holidays::observed::nearest);
+			static_assert(r.date(2020y) == 2020y / 7 / 3);
+			static_assert(r.date(2021y) == 2021y / 7 / 5);
+			static_assert(r.date(2023y) == 2023y / 7 / 4);
+			static_assert(r(2020y / 7 / 3) and !r(2020y / 7 / 4));
+			constexpr auto n = holidays::fixed(std::chrono::January, 1d, holidays::observed::nearest);
+			static_assert(n.date(2022y) == 2021y / 12 / 31);
+			static_assert(n(2021y / 12 / 31));
+			static_assert(holidays::nth_weekday(4, std::chrono::Thursday, std::chrono::November).date(2023y) == 2023y / 11 / 23);
+			static_assert(holidays::last_weekday(std::chrono::Monday, std::chrono::May).date(2023y) == 2023y / 5 / 29);
+			static_assert(!holidays::once(2001y / 9 / 11).date(2002y).ok());
+		}
+		{
+			// NYSE 2023
+			constexpr ymd closed[] = {
+				2023y / 1 / 2, 2023y / 1 / 16, 2023y / 2 / 20, 2023y / 4 / 7, 2023y / 5 / 29,
+				2023y / 6 / 19, 2023y / 7 / 4, 2023y / 9 / 4, 2023y / 11 / 23, 2023y / 12 / 25,
+			};
+			for ([[maybe_unused]] const auto& d : closed) {
+				assert(calendars::nyse(d));
+			}
+			static_assert(!calendars::nyse(2021y / 12 / 31)); // New Year's Day on Saturday
+			static_assert(!calendars::nyse(2021y / 6 / 18));
+			static_assert(calendars::nyse(2022y / 6 / 20));
+			static_assert(calendars::nyse(2012y / 10 / 29));
+			static_assert(!calendars::nyse(2023y / 10 / 9)); // Columbus Day
+			static_assert(calendars::sifma(2023y / 10 / 9));
+			static_assert(calendars::sifma(2023y / 11 / 10) == false);
+			static_assert(calendars::target(2024y / 4 / 1)); // Easter Monday
+			static_assert(calendars::target(2024y / 5 / 1));
+			static_assert(!calendars::target(2024y / 7 / 4));
+			static_assert(calendars::target(2001y / 12 / 31));
+			static_assert(!calendars::target(2002y / 12 / 31));
+		}
+		{
+			// compiled rules agree with evaluating rules every day
+			const auto from = make_serial(1990, 1, 1);
+			const auto to = make_serial(2040, 1, 1);
+			const auto nyse = compile(holidays::nyse, calendars::nyse, from, to);
+			const auto target = compile(holidays::target, calendars::target, from, to);
+			for (auto s = nyse.begin() - serial::duration(400); s < nyse.end() + serial::duration(400); s += serial::duration(1)) {
+				assert(nyse(to_ymd(s)) == calendars::nyse(to_ymd(s)));
+				assert(target(to_ymd(s)) == calendars::target(to_ymd(s)));
+			}
+			assert(calendars::compiled::sifma().is_business_day(make_serial(2023, 10, 10)));
+			assert(!calendars::compiled::sifma().is_business_day(make_serial(2023, 10, 9)));
+			assert(adjust(make_serial(2023, 4, 7), roll::following, calendars::compiled::nyse()) == make_serial(2023, 4, 10));
+			assert(adjust(make_serial(2024, 3, 29), roll::following, calendars::compiled::target()) == make_serial(2024, 4, 2));
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
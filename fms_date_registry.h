@@ -0,0 +1,471 @@
+// fms_date_registry.h - Calendars by name
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "fms_date_holiday.h"
+
+namespace fms::date {
+
+	// Compiled calendars by name or joint name such as "NYSE+TARGET".
+	// Readers load an immutable hash table with one atomic load and never wait.
+	// Writers copy the table, change the copy, and publish it under a mutex.
+	// Replaced tables are reclaimed read-copy-update style once no reader
+	// that might have loaded them remains, so readers never take a lock.
+	class calendar_registry {
+		struct entry {
+			std::string name;
+			std::shared_ptr<const compiled_calendar> cal; // null if the slot is empty
+		};
+		// Open addressing with linear probing. Size is zero or a power of 2 at most half full.
+		struct table {
+			std::vector<entry> slots;
+			size_t count = 0;
+
+			const entry* find(std::string_view name) const
+			{
+				if (slots.empty()) {
+					return nullptr;
+				}
+
+				const size_t mask = slots.size() - 1;
+				for (size_t i = std::hash<std::string_view>{}(name) & mask; slots[i].cal; i = (i + 1) & mask) {
+					if (slots[i].name == name) {
+						return &slots[i];
+					}
+				}
+
+				return nullptr;
+			}
+			void insert(entry e)
+			{
+				const size_t mask = slots.size() - 1;
+				size_t i = std::hash<std::string_view>{}(e.name) & mask;
+				while (slots[i].cal and slots[i].name != e.name) {
+					i = (i + 1) & mask;
+				}
+				count += !slots[i].cal;
+				slots[i] = std::move(e);
+			}
+		};
+		// Readers in each epoch parity striped over cache lines by thread.
+		static constexpr size_t stripes = 16;
+		struct alignas(64) counter {
+			std::atomic<int64_t> n = 0;
+		};
+
+		std::atomic<const table*> current;
+		std::unique_ptr<const table> owner; // current table
+		mutable std::atomic<uint64_t> epoch = 0;
+		mutable counter readers[2][stripes];
+		std::mutex mutex; // serializes writers
+		std::vector<std::pair<uint64_t, std::unique_ptr<const table>>> retired; // epoch when replaced and table
+	public:
+		// Tables loaded while a reader is alive are not reclaimed, so calendars
+		// found through it stay valid even if their names are updated.
+		// Entering and leaving is one atomic increment and decrement.
+		class reader {
+			const calendar_registry& r;
+			counter& c;
+		public:
+			explicit reader(const calendar_registry& r)
+				: r{ r }, c{ r.enter() }
+			{ }
+			reader(const reader&) = delete;
+			reader& operator=(const reader&) = delete;
+			~reader()
+			{
+				c.n.fetch_sub(1, std::memory_order_release);
+			}
+
+			// Calendar registered as name or nullptr.
+			const compiled_calendar* find(std::string_view name) const
+			{
+				const auto e = r.current.load()->find(name);
+
+				return e ? e->cal.get() : nullptr;
+			}
+		};
+
+		calendar_registry()
+			: owner{ std::make_unique<const table>() }
+		{
+			current.store(owner.get());
+		}
+		calendar_registry(const calendar_registry&) = delete;
+		calendar_registry& operator=(const calendar_registry&) = delete;
+
+		// Number of names including joint names.
+		size_t size() const
+		{
+			const reader guard(*this);
+
+			return current.load()->count;
+		}
+
+		// Calendar registered as name or null. Wait free.
+		// The calendar is owned by the result and outlives updates of name.
+		// Use a reader on hot paths to avoid the shared reference count.
+		std::shared_ptr<const compiled_calendar> find(std::string_view name) const
+		{
+			const reader guard(*this);
+			const auto e = current.load()->find(name);
+
+			return e ? e->cal : nullptr;
+		}
+
+		// Register cal as name. Return false if name is in use.
+		bool add(std::string_view name, compiled_calendar cal)
+		{
+			std::lock_guard lock(mutex);
+			if (current.load()->find(name)) {
+				return false;
+			}
+			publish({ entry{ std::string(name), std::make_shared<const compiled_calendar>(std::move(cal)) } });
+			collect();
+
+			return true;
+		}
+
+		// Publish a new version of name and of the joint calendars containing it
+		// in one table. Each lookup sees the old or the new table. Pointers a reader
+		// already returned stay valid until it is destroyed, but its later lookups
+		// see the new versions. Waits for readers alive during the update without
+		// holding the writer mutex, so readers may add calendars meanwhile,
+		// but do not call while this thread holds a reader.
+		void update(std::string_view name, compiled_calendar cal)
+		{
+			std::unique_lock lock(mutex);
+			const auto t = current.load();
+			std::vector<entry> entries{ entry{ std::string(name), std::make_shared<const compiled_calendar>(std::move(cal)) } };
+			std::map<std::string, std::shared_ptr<const compiled_calendar>> joints; // by sorted names
+			for (const auto& e : t->slots) {
+				if (!e.cal or e.name.find('+') == std::string::npos) {
+					continue;
+				}
+				const auto names = split(e.name);
+				if (std::find(names.begin(), names.end(), name) != names.end()) {
+					auto& j = joints[join(names)];
+					if (!j) {
+						j = unite(*t, names, &entries[0]);
+					}
+					entries.push_back(entry{ e.name, j });
+				}
+			}
+			publish(std::move(entries));
+			lock.unlock();
+			reclaim();
+		}
+
+		// Free tables replaced before the call once every reader that might use them is gone.
+		// The tables are taken under the writer mutex and freed after it is released.
+		// Do not call while this thread holds a reader.
+		void reclaim()
+		{
+			std::vector<std::pair<uint64_t, std::unique_ptr<const table>>> tables;
+			{
+				std::lock_guard lock(mutex);
+				tables.swap(retired);
+			}
+			if (tables.empty()) {
+				return;
+			}
+
+			const auto e = tables.back().first;
+			while (epoch.load() < e + 2) {
+				if (!advance()) {
+					std::this_thread::yield();
+				}
+			}
+		}
+
+		// Calendar for name or names joined by '+', or null if a name is not registered.
+		// The union of holidays for a new joint name is built once and registered under
+		// name and the sorted names, so later lookups are wait free.
+		std::shared_ptr<const compiled_calendar> operator()(std::string_view name)
+		{
+			if (auto cal = find(name)) {
+				return cal;
+			}
+			if (name.find('+') == std::string_view::npos) {
+				return nullptr;
+			}
+
+			const auto names = split(name);
+			const auto key = join(names);
+
+			std::lock_guard lock(mutex);
+			const auto t = current.load();
+			std::shared_ptr<const compiled_calendar> cal;
+			if (const auto e = t->find(key)) {
+				cal = e->cal;
+			}
+			else if (!(cal = unite(*t, names))) {
+				return nullptr;
+			}
+			publish({ entry{ std::string(name), cal }, entry{ key, cal } });
+			collect();
+
+			return cal;
+		}
+
+		// Register NYSE, SIFMA, and TARGET compiled calendars.
+		calendar_registry& add_exchanges()
+		{
+			add("NYSE", calendars::compiled::nyse());
+			add("SIFMA", calendars::compiled::sifma());
+			add("TARGET", calendars::compiled::target());
+
+			return *this;
+		}
+	private:
+		// Count a reader in the current epoch.
+		// The epoch is read again after counting: if it moved to the other parity
+		// in between, advance may have missed the count, so leave and retry.
+		counter& enter() const
+		{
+			static thread_local const size_t stripe = std::hash<std::thread::id>{}(std::this_thread::get_id()) % stripes;
+			for (;;) {
+				const auto e = epoch.load();
+				auto& c = readers[e & 1][stripe];
+				c.n.fetch_add(1);
+				if (((epoch.load() ^ e) & 1) == 0) {
+					return c;
+				}
+				c.n.fetch_sub(1);
+			}
+		}
+
+		// Move to the next epoch if no reader entered in the previous one remains.
+		// A table replaced in epoch e is unused once the epoch reaches e + 2: every
+		// reader that might have loaded it entered in epoch e or e - 1 and has left.
+		bool advance() const
+		{
+			auto e = epoch.load();
+			for (const auto& c : readers[(e + 1) & 1]) {
+				if (c.n.load() != 0) {
+					return false;
+				}
+			}
+
+			epoch.compare_exchange_strong(e, e + 1); // fails only if another thread advanced
+
+			return true;
+		}
+
+		// Free retired tables no reader can use without waiting. Caller holds mutex.
+		void collect()
+		{
+			advance() and advance();
+			const auto e = epoch.load();
+			std::erase_if(retired, [e](const auto& t) { return t.first + 2 <= e; });
+		}
+
+		// Sorted unique names joined by '+'.
+		static std::vector<std::string_view> split(std::string_view name)
+		{
+			std::vector<std::string_view> names;
+			for (auto s = name; !s.empty();) {
+				const auto n = s.find('+');
+				names.push_back(s.substr(0, n));
+				s.remove_prefix(n == std::string_view::npos ? s.size() : n + 1);
+			}
+			std::sort(names.begin(), names.end());
+			names.erase(std::unique(names.begin(), names.end()), names.end());
+
+			return names;
+		}
+		static std::string join(const std::vector<std::string_view>& names)
+		{
+			std::string key;
+			for (const auto& n : names) {
+				key.append(key.empty() ? "" : "+").append(n);
+			}
+
+			return key;
+		}
+		// Union of holidays of names in t, using e in place of the entry with the same name.
+		// Null if a name is not registered.
+		static std::shared_ptr<const compiled_calendar> unite(const table& t, const std::vector<std::string_view>& names, const entry* e = nullptr)
+		{
+			compiled_calendar c;
+			for (size_t i = 0; i < names.size(); ++i) {
+				const auto ei = e and e->name == names[i] ? e : t.find(names[i]);
+				if (!ei) {
+					return nullptr;
+				}
+				c = i == 0 ? *ei->cal : c | *ei->cal;
+			}
+
+			return std::make_shared<const compiled_calendar>(std::move(c));
+		}
+
+		// Copy the current table with entries added or replaced and make it current.
+		// The old table is retired until collected or reclaimed. Caller holds mutex.
+		void publish(std::vector<entry> entries)
+		{
+			const auto t = current.load();
+			auto u = std::make_unique<table>();
+			size_t n = 8;
+			while (n < 2 * (t->count + entries.size())) {
+				n *= 2;
+			}
+			u->slots.resize(n);
+			for (const auto& e : t->slots) {
+				if (e.cal) {
+					u->insert(e);
+				}
+			}
+			for (auto& e : entries) {
+				u->insert(std::move(e));
+			}
+			current.store(u.get());
+			retired.emplace_back(epoch.load(), std::move(owner));
+			owner = std::move(u);
+		}
+	};
+
+#ifdef _DEBUG
+	inline int registry_test()
+	{
+		{
+			calendar_registry r;
+			assert(r.size() == 0);
+			assert(!r.find("NYSE"));
+			assert(!r("NYSE+TARGET"));
+			r.add_exchanges();
+			assert(r.size() == 3);
+			assert(!r.add("NYSE", compiled_calendar{}));
+			const auto nyse = r.find("NYSE");
+			assert(nyse and nyse->words().data() == calendars::compiled::nyse().words().data());
+
+			const auto u = r("TARGET+NYSE");
+			assert(u and r.size() == 5);
+			assert(r.find("NYSE+TARGET") == u and r("TARGET+NYSE") == u);
+			assert(r("NYSE+TARGET+NYSE") == u and r.size() == 6);
+			assert(!r("NYSE+XXXX"));
+			assert(r.find("NYSE") == nyse);
+			r.update("NYSE", compiled_calendar{});
+			assert(r.find("NYSE") != nyse);
+			assert(nyse->words().data() == calendars::compiled::nyse().words().data()); // still owned after the update
+			[[maybe_unused]] const auto& target = calendars::compiled::target();
+			for (auto s = make_serial(2023, 1, 1); s < make_serial(2025, 1, 1); s += serial::duration(1)) {
+				assert(u->is_business_day(s) == (nyse->is_business_day(s) and target.is_business_day(s)));
+			}
+		}
+		{
+			// readers during writes
+			calendar_registry r;
+			r.add("W", compiled_calendar(calendars::weekday, make_serial(2020, 1, 1), make_serial(2021, 1, 1)));
+			std::atomic<bool> done = false;
+			std::vector<std::thread> readers;
+			for (int i = 0; i < 4; ++i) {
+				readers.emplace_back([&r, &done] {
+					while (!done.load()) {
+						const auto w = r.find("W");
+						assert(w and w->is_business_day(make_serial(2020, 6, 1)));
+					}
+				});
+			}
+			for (int i = 0; i < 200; ++i) {
+				r.add(std::string("C").append(std::to_string(i)), compiled_calendar{});
+			}
+			done = true;
+			for (auto& t : readers) {
+				t.join();
+			}
+			assert(r.size() == 201);
+			assert(r.find("C199"));
+		}
+		{
+			// pointers a reader found stay valid while its new lookups see the update
+			calendar_registry r;
+			r.add_exchanges();
+			r("TARGET+NYSE");
+			const auto closure = make_serial(2024, 7, 5);
+			const serial closed[] = { closure };
+			auto nyse = calendars::compiled::nyse();
+			nyse.close(closed);
+
+			std::atomic<bool> entered = false;
+			std::thread t([&r, &entered, closure] {
+				const calendar_registry::reader g(r);
+				const auto old = g.find("NYSE");
+				entered = true;
+				while (r.find("NYSE").get() == old) {
+					std::this_thread::yield();
+				}
+				assert(old->is_business_day(closure));
+				assert(g.find("NYSE") != old and !g.find("NYSE")->is_business_day(closure));
+			});
+			while (!entered) {
+				std::this_thread::yield();
+			}
+			r.update("NYSE", nyse); // waits for t to leave its reader
+			t.join();
+			assert(!r.find("NYSE")->is_business_day(closure));
+			assert(!r.find("NYSE+TARGET")->is_business_day(closure));
+			assert(r.find("TARGET+NYSE") == r.find("NYSE+TARGET"));
+			assert(r.find("TARGET")->is_business_day(closure));
+			assert(r.size() == 5);
+		}
+		{
+			// a reader may add calendars while another thread waits for it in update
+			calendar_registry r;
+			r.add_exchanges();
+			std::atomic<bool> entered = false;
+			std::thread t([&r, &entered] {
+				const calendar_registry::reader g(r);
+				const auto old = g.find("NYSE");
+				entered = true;
+				while (r.find("NYSE").get() == old) {
+					std::this_thread::yield();
+				}
+				assert(r("NYSE+SIFMA"));
+				assert(r.add("W", compiled_calendar{}));
+			});
+			while (!entered) {
+				std::this_thread::yield();
+			}
+			r.update("NYSE", compiled_calendar(calendars::compiled::nyse()));
+			t.join();
+			assert(r.size() == 5);
+		}
+		{
+			// readers during updates
+			calendar_registry r;
+			r.add_exchanges();
+			r("NYSE+SIFMA");
+			std::atomic<bool> done = false;
+			std::vector<std::thread> readers;
+			for (int i = 0; i < 4; ++i) {
+				readers.emplace_back([&r, &done] {
+					while (!done.load()) {
+						const calendar_registry::reader g(r);
+						[[maybe_unused]] const auto c = g.find("NYSE+SIFMA");
+						assert(c and c->business_days(make_serial(2024, 1, 1), make_serial(2024, 2, 1)) > 15);
+					}
+				});
+			}
+			for (int i = 0; i < 100; ++i) {
+				const serial closed[] = { make_serial(2024, 1, 2) + serial::duration(i % 20) };
+				r.update("NYSE", compiled_calendar(calendars::compiled::nyse()).close(closed));
+			}
+			done = true;
+			for (auto& t : readers) {
+				t.join();
+			}
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
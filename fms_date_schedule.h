@@ -0,0 +1,183 @@
+// fms_date_schedule.h - Coupon periods stored as columns
+#pragma once
+#include <cmath>
+#include <span>
+#include <vector>
+#include "fms_date_batch.h"
+
+namespace fms::date {
+
+	// Date of a period boundary. Days past the end of the month, such as
+	// 2025-02-31 from periodic, are clamped to the last day of the month.
+	constexpr serial to_serial_clamped(const ymd& d)
+	{
+		return to_serial(d.ok() ? d : d.year() / d.month() / std::chrono::last);
+	}
+
+	// Coupon periods of a periodic schedule computed once.
+	// Each column is a contiguous array so valuation loops do no date arithmetic.
+	class schedule {
+		std::vector<serial> unadjusted_start_, unadjusted_end_;
+		std::vector<serial> adjusted_start_, adjusted_end_;
+		std::vector<serial> payment_;
+		std::vector<double> fraction_;
+	public:
+		schedule() = default;
+		// Periods between dates of p adjusted with convention and calendar.
+		schedule(const periodic& p, day_count dc, roll convention = roll::modified_following, const calendar& cal = calendars::weekday)
+		{
+			const size_t n = p.size();
+			std::vector<serial> d;
+			d.reserve(n);
+			for (const auto& di : p) {
+				d.push_back(to_serial_clamped(di));
+			}
+
+			init(d, dc, convention, cal);
+		}
+		// Periods working back from termination with a short front stub starting at effective.
+		schedule(ymd effective, ymd termination, int months, day_count dc, roll convention = roll::modified_following, const calendar& cal = calendars::weekday)
+		{
+			const auto p = periodic(effective, termination, months);
+			std::vector<serial> d;
+			d.reserve(p.size() + 1);
+			if (to_serial_clamped(p[0]) != to_serial(effective)) {
+				d.push_back(to_serial(effective));
+			}
+			for (const auto& di : p) {
+				d.push_back(to_serial_clamped(di));
+			}
+
+			init(d, dc, convention, cal);
+		}
+
+		// Number of periods.
+		size_t size() const
+		{
+			return fraction_.size();
+		}
+
+		std::span<const serial> unadjusted_start() const
+		{
+			return unadjusted_start_;
+		}
+		std::span<const serial> unadjusted_end() const
+		{
+			return unadjusted_end_;
+		}
+		std::span<const serial> adjusted_start() const
+		{
+			return adjusted_start_;
+		}
+		std::span<const serial> adjusted_end() const
+		{
+			return adjusted_end_;
+		}
+		// Payment at the adjusted end of each period.
+		std::span<const serial> payment() const
+		{
+			return payment_;
+		}
+		// Day count fraction of adjusted period.
+		std::span<const double> fraction() const
+		{
+			return fraction_;
+		}
+	private:
+		// Fill columns from the unadjusted period boundaries d.
+		void init(const std::vector<serial>& d, day_count dc, roll convention, const calendar& cal)
+		{
+			if (d.size() < 2) {
+				return;
+			}
+			const size_t n = d.size() - 1;
+
+			std::vector<serial> a(d.size());
+			for (size_t i = 0; i < d.size(); ++i) {
+				a[i] = adjust(d[i], convention, cal);
+			}
+
+			unadjusted_start_.assign(d.begin(), d.end() - 1);
+			unadjusted_end_.assign(d.begin() + 1, d.end());
+			adjusted_start_.assign(a.begin(), a.end() - 1);
+			adjusted_end_.assign(a.begin() + 1, a.end());
+			payment_ = adjusted_end_;
+			fraction_.resize(n);
+			// each boundary is converted once for conventions that need fields
+			std::vector<ymd> y(a.size());
+			to_ymd(a, y);
+			const std::span<const ymd> ys(y);
+			dcf::batch(dc, ys.first(n), ys.subspan(1), fraction_);
+		}
+	};
+
+#ifdef _DEBUG
+	inline int schedule_test()
+	{
+		{
+			schedule s;
+			assert(s.size() == 0);
+		}
+		{
+			// 2023-09-30 and 2024-03-30 are Saturdays
+			const auto p = periodic(make_ymd(2023, 4, 30), make_ymd(2024, 9, 30), 6);
+			const schedule s(p, day_count::_actual_360, roll::following);
+			assert(s.size() == 2);
+			assert(s.unadjusted_start()[0] == make_serial(2023, 9, 30));
+			assert(s.unadjusted_end()[0] == make_serial(2024, 3, 30));
+			assert(s.adjusted_start()[0] == make_serial(2023, 10, 2));
+			assert(s.adjusted_end()[0] == make_serial(2024, 4, 1));
+			assert(s.payment()[1] == make_serial(2024, 9, 30));
+			assert(s.fraction()[0] == 182 / 360.);
+			assert(s.fraction()[1] == 182 / 360.);
+		}
+		{
+			const schedule s(make_ymd(2023, 4, 30), make_ymd(2024, 9, 30), 6, day_count::_30_360);
+			assert(s.size() == 3);
+			assert(s.unadjusted_start()[0] == make_serial(2023, 4, 30));
+			assert(s.adjusted_start()[0] == make_serial(2023, 4, 28));
+			assert(s.adjusted_end()[0] == make_serial(2023, 9, 29));
+			assert(s.fraction()[0] == dcf::_30_360(make_ymd(2023, 4, 28), make_ymd(2023, 9, 29)).count());
+			double sum = 0;
+			for (auto f : s.fraction()) {
+				sum += f;
+			}
+			assert(std::abs(sum - dcf::_30_360(make_ymd(2023, 4, 28), make_ymd(2024, 9, 30)).count()) < 1e-12);
+		}
+		{
+			// month end monthly periods stay in their month
+			static_assert(to_serial_clamped(make_ymd(2025, 2, 31)) == make_serial(2025, 2, 28));
+			static_assert(to_serial_clamped(make_ymd(2024, 2, 30)) == make_serial(2024, 2, 29));
+			const schedule s(make_ymd(2025, 1, 31), make_ymd(2025, 8, 31), 1, day_count::_30E_360, roll::none);
+			[[maybe_unused]] const serial ends[] = {
+				make_serial(2025, 2, 28), make_serial(2025, 3, 31), make_serial(2025, 4, 30), make_serial(2025, 5, 31),
+				make_serial(2025, 6, 30), make_serial(2025, 7, 31), make_serial(2025, 8, 31),
+			};
+			assert(s.size() == 7);
+			assert(s.unadjusted_start()[0] == make_serial(2025, 1, 31));
+			assert(std::ranges::equal(s.unadjusted_end(), ends));
+			assert(s.fraction()[0] == dcf::_30E_360(make_ymd(2025, 1, 31), make_ymd(2025, 2, 28)).count());
+			assert(s.fraction()[2] == 30 / 360.);
+		}
+		{
+			// effective is the clamped first period date: no zero length stub
+			const schedule s(make_ymd(2025, 2, 28), make_ymd(2025, 8, 31), 1, day_count::_30E_360, roll::none);
+			assert(s.size() == 6);
+			assert(s.unadjusted_start()[0] == make_serial(2025, 2, 28));
+			assert(s.unadjusted_end()[0] == make_serial(2025, 3, 31));
+			for ([[maybe_unused]] auto f : s.fraction()) {
+				assert(f > 0);
+			}
+		}
+		{
+			// no stub when effective is a period date
+			const schedule s(make_ymd(2023, 1, 15), make_ymd(2024, 1, 15), 3, day_count::_actual_365);
+			assert(s.size() == 4);
+			assert(s.unadjusted_start()[0] == make_serial(2023, 1, 15));
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date
@@ -0,0 +1,345 @@
+// fms_date_text.h - Parse and format dates as text
+#pragma once
+#include <array>
+#include <charconv>
+#include <cstdio>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "fms_date_batch.h"
+
+namespace fms::date {
+
+	namespace text {
+
+		constexpr bool leap_year(int32_t y)
+		{
+			return y % 4 == 0 and (y % 100 != 0 or y % 400 == 0);
+		}
+		// Days since 1970-01-01 if y, m, d is a valid date.
+		constexpr bool days(int32_t y, uint32_t m, uint32_t d, int32_t& s)
+		{
+			const uint32_t last = m == 2 ? 28 + leap_year(y) : 30 + ((m + (m >> 3)) & 1);
+			if (m - 1 >= 12 or d - 1 >= last) {
+				return false;
+			}
+			s = days_from_civil(y, m, d);
+
+			return true;
+		}
+
+		// One character at a time. Parsing eight digits at once in a 64-bit
+		// word was measured to be no faster.
+		constexpr bool parse(std::string_view t, int32_t& s)
+		{
+			const auto digits = [t](size_t i, size_t n, uint32_t& x) {
+				x = 0;
+				for (size_t j = i; j < i + n; ++j) {
+					if (t[j] < '0' or t[j] > '9') {
+						return false;
+					}
+					x = 10 * x + (t[j] - '0');
+				}
+				return true;
+			};
+
+			uint32_t y, m, d;
+			if (t.size() == 10) {
+				if (t[4] != '-' or t[7] != '-' or !digits(0, 4, y) or !digits(5, 2, m) or !digits(8, 2, d)) {
+					return false;
+				}
+			}
+			else if (t.size() == 8) {
+				if (!digits(0, 4, y) or !digits(4, 2, m) or !digits(6, 2, d)) {
+					return false;
+				}
+			}
+			else {
+				return false;
+			}
+
+			return days((int32_t)y, m, d, s);
+		}
+
+	} // namespace text
+
+	// Parse YYYY-MM-DD or YYYYMMDD. Return false if t is malformed or not a date.
+	constexpr bool parse_date(std::string_view t, serial& s)
+	{
+		int32_t n = 0;
+		const bool ok = text::parse(t, n);
+		if (ok) {
+			s = serial(serial::duration(n));
+		}
+
+		return ok;
+	}
+
+	// Parse dates as YYYY-MM-DD or YYYYMMDD. S is int32_t or serial.
+	// Return the index of the first malformed entry, or n if all parse.
+	template<class S>
+	inline size_t parse_dates_n(const std::string_view* t, size_t n, S* s)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			int32_t si;
+			if (!text::parse(t[i], si)) {
+				return i;
+			}
+			if constexpr (std::is_same_v<S, serial>) {
+				s[i] = serial(serial::duration(si));
+			}
+			else {
+				s[i] = si;
+			}
+		}
+
+		return n;
+	}
+
+	// Parse dates into s. Return the number of dates parsed.
+	// If that is less than the size of both spans it is the index of the first malformed entry.
+	inline size_t parse_dates(std::span<const std::string_view> t, std::span<serial> s)
+	{
+		return parse_dates_n(t.data(), std::min(t.size(), s.size()), s.data());
+	}
+	inline size_t parse_dates(std::span<const std::string_view> t, std::span<int32_t> s)
+	{
+		return parse_dates_n(t.data(), std::min(t.size(), s.size()), s.data());
+	}
+
+	// Fixed width date formats.
+	enum class date_format {
+		iso,         // YYYY-MM-DD
+		compact,     // YYYYMMDD
+		dd_mmm_yyyy, // DD-Mon-YYYY
+	};
+	constexpr size_t width(date_format f)
+	{
+		return f == date_format::iso ? 10 : f == date_format::compact ? 8 : 11;
+	}
+
+	namespace text {
+
+		// "00" to "99"
+		inline constexpr auto digits2 = [] {
+			std::array<char, 200> a{};
+			for (int i = 0; i < 100; ++i) {
+				a[2 * i] = (char)('0' + i / 10);
+				a[2 * i + 1] = (char)('0' + i % 10);
+			}
+			return a;
+		}();
+		inline constexpr char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+		// Write width(f) characters for a date with year in [0, 9999].
+		constexpr void format(char* p, uint32_t y, uint32_t m, uint32_t d, date_format f)
+		{
+			const auto put2 = [](char* q, uint32_t i) {
+				q[0] = digits2[2 * i];
+				q[1] = digits2[2 * i + 1];
+			};
+
+			switch (f) {
+			case date_format::iso:
+				put2(p, y / 100);
+				put2(p + 2, y % 100);
+				p[4] = '-';
+				put2(p + 5, m);
+				p[7] = '-';
+				put2(p + 8, d);
+				break;
+			case date_format::compact:
+				put2(p, y / 100);
+				put2(p + 2, y % 100);
+				put2(p + 4, m);
+				put2(p + 6, d);
+				break;
+			case date_format::dd_mmm_yyyy:
+				put2(p, d);
+				p[2] = '-';
+				p[3] = months[3 * (m - 1)];
+				p[4] = months[3 * (m - 1) + 1];
+				p[5] = months[3 * (m - 1) + 2];
+				p[6] = '-';
+				put2(p + 7, y / 100);
+				put2(p + 9, y % 100);
+				break;
+			}
+		}
+
+	} // namespace text
+
+	// Write date in format f to [first, last) without allocating.
+	// Error is value_too_large if the range is too short and invalid_argument
+	// if the year does not have 4 digits.
+	constexpr std::to_chars_result to_chars(char* first, char* last, const serial& s, date_format f = date_format::iso)
+	{
+		if (last - first < (ptrdiff_t)width(f)) {
+			return { last, std::errc::value_too_large };
+		}
+
+		int32_t y;
+		uint32_t m, d;
+		civil_from_days(s.time_since_epoch().count(), y, m, d);
+		if (y < 0 or y > 9999) {
+			return { last, std::errc::invalid_argument };
+		}
+		text::format(first, (uint32_t)y, m, d, f);
+
+		return { first + width(f), std::errc{} };
+	}
+	constexpr std::to_chars_result to_chars(char* first, char* last, const ymd& date, date_format f = date_format::iso)
+	{
+		return to_chars(first, last, serial(serial::duration(days_from_civil(date))), f);
+	}
+
+	// Write n dates as records of width(f) characters followed by sep unless sep is 0.
+	// Return the index of the first date with a year that does not have 4 digits, or n.
+	inline size_t format_dates_n(const serial* s, size_t n, char* out, date_format f, char sep)
+	{
+		const size_t w = width(f);
+		const size_t stride = w + (sep != 0);
+		int32_t y[batch_block];
+		uint32_t m[batch_block], d[batch_block];
+
+		for (size_t i = 0; i < n; i += batch_block) {
+			const size_t k = std::min(batch_block, n - i);
+			for (size_t j = 0; j < k; ++j) {
+				civil_from_days(s[i + j].time_since_epoch().count(), y[j], m[j], d[j]);
+			}
+			for (size_t j = 0; j < k; ++j) {
+				if ((uint32_t)y[j] > 9999) {
+					return i + j;
+				}
+				char* p = out + (i + j) * stride;
+				text::format(p, (uint32_t)y[j], m[j], d[j], f);
+				if (sep) {
+					p[w] = sep;
+				}
+			}
+		}
+
+		return n;
+	}
+
+	// Format dates into one buffer of fixed width records. Return the number of dates written.
+	// If that is less than the number of dates and records that fit in out, it is
+	// the index of the first date with a year that does not have 4 digits.
+	inline size_t format_dates(std::span<const serial> s, std::span<char> out, date_format f = date_format::iso, char sep = 0)
+	{
+		const size_t n = std::min(s.size(), out.size() / (width(f) + (sep != 0)));
+
+		return format_dates_n(s.data(), n, out.data(), f, sep);
+	}
+
+#ifdef _DEBUG
+	inline int text_test()
+	{
+		{
+			serial s{};
+			constexpr auto p = [](std::string_view t) {
+				serial s{};
+				return parse_date(t, s) ? s : serial{ serial::duration(-1) };
+			};
+			static_assert(p("2023-04-05") == make_serial(2023, 4, 5));
+			static_assert(p("20240229") == make_serial(2024, 2, 29));
+			static_assert(p("19000101") == make_serial(1900, 1, 1));
+			static_assert(p("2023-02-29") == serial{ serial::duration(-1) });
+			static_assert(p("2023-4-05") == serial{ serial::duration(-1) });
+			[[maybe_unused]] bool ok = parse_date("2023-04-05", s);
+			assert(ok and s == make_serial(2023, 4, 5));
+			ok = parse_date("21000228", s);
+			assert(ok and s == make_serial(2100, 2, 28));
+			for ([[maybe_unused]] auto t : { "2100-02-29", "2023-13-01", "2023-00-10", "2023-01-00", "2023-01-32", "2023/01/02", "2023-01-0a",
+				"202301:2", "2023010", "230101", "", "2023-01-011", " 2023-01-01", "2O230101", "2023\xFA" "0101" }) {
+				[[maybe_unused]] int32_t n;
+				assert(!parse_date(t, s));
+				assert(!text::parse(t, n));
+			}
+		}
+		{
+			// every date in both formats agrees with <chrono>
+			for (auto s = make_serial(1900, 1, 1); s < make_serial(2201, 1, 1); s += serial::duration(1)) {
+				const auto d = to_ymd(s);
+				char iso[40], compact[40]; // room for any int and unsigned fields
+				std::snprintf(iso, sizeof(iso), "%04d-%02u-%02u", (int)d.year(), (unsigned)d.month(), (unsigned)d.day());
+				std::snprintf(compact, sizeof(compact), "%04d%02u%02u", (int)d.year(), (unsigned)d.month(), (unsigned)d.day());
+				int32_t n0, n1;
+				[[maybe_unused]] const bool ok0 = text::parse(iso, n0);
+				[[maybe_unused]] const bool ok1 = text::parse(compact, n1);
+				assert(ok0 and n0 == s.time_since_epoch().count());
+				assert(ok1 and n1 == n0);
+			}
+		}
+		{
+			const std::string_view t[] = { "2023-04-05", "20230406", "2023-04-31", "2023-04-07" };
+			serial s[4];
+			int32_t n[4];
+			[[maybe_unused]] size_t k = parse_dates(t, s);
+			assert(k == 2);
+			assert(s[0] == make_serial(2023, 4, 5) and s[1] == make_serial(2023, 4, 6));
+			k = parse_dates(std::span(t, 2), n);
+			assert(k == 2);
+			assert(n[1] == make_serial(2023, 4, 6).time_since_epoch().count());
+			k = parse_dates(std::span(t + 3, 1), s);
+			assert(k == 1);
+			k = parse_dates(t, std::span(s, 1));
+			assert(k == 1);
+		}
+		{
+			constexpr auto f = [](const ymd& d, date_format fmt) {
+				std::array<char, 12> buf{};
+				const auto [p, ec] = to_chars(buf.data(), buf.data() + buf.size(), d, fmt);
+				return ec == std::errc{} ? std::string_view(buf.data(), p - buf.data()) == (fmt == date_format::iso ? "2023-04-05" : fmt == date_format::compact ? "20230405" : "05-Apr-2023") : false;
+			};
+			static_assert(f(make_ymd(2023, 4, 5), date_format::iso));
+			static_assert(f(make_ymd(2023, 4, 5), date_format::compact));
+			static_assert(f(make_ymd(2023, 4, 5), date_format::dd_mmm_yyyy));
+
+			char buf[11];
+			assert(to_chars(buf, buf + 9, make_serial(2023, 12, 31)).ec == std::errc::value_too_large);
+			assert(to_chars(buf, buf + 11, make_serial(10000, 1, 1)).ec == std::errc::invalid_argument);
+			assert(to_chars(buf, buf + 11, make_serial(-1, 1, 1)).ec == std::errc::invalid_argument);
+			auto r = to_chars(buf, buf + 11, make_serial(12, 12, 31), date_format::dd_mmm_yyyy);
+			assert(r.ptr == buf + 11 and std::string_view(buf, 11) == "31-Dec-0012");
+			r = to_chars(buf, buf + 11, make_serial(9999, 1, 9), date_format::compact);
+			assert(r.ptr == buf + 8 and std::string_view(buf, 8) == "99990109");
+		}
+		{
+			// round trip every date through the batch formatter and parser
+			std::vector<serial> s;
+			for (auto t = make_serial(1900, 1, 1); t < make_serial(2201, 1, 1); t += serial::duration(1)) {
+				s.push_back(t);
+			}
+			for (auto f : { date_format::iso, date_format::compact }) {
+				for (char sep : { '\0', '\n' }) {
+					const size_t stride = width(f) + (sep != 0);
+					std::vector<char> out(s.size() * stride);
+					[[maybe_unused]] size_t k = format_dates(s, out, f, sep);
+					assert(k == s.size());
+					std::vector<std::string_view> t(s.size());
+					for (size_t i = 0; i < s.size(); ++i) {
+						t[i] = std::string_view(out.data() + i * stride, width(f));
+						assert(!sep or out[i * stride + width(f)] == sep);
+					}
+					std::vector<serial> s_(s.size());
+					k = parse_dates(t, s_);
+					assert(k == s.size());
+					assert(s_ == s);
+				}
+			}
+			std::vector<char> out(width(date_format::dd_mmm_yyyy) * 3 + 2);
+			const serial t[] = { make_serial(2024, 2, 29), make_serial(1999, 11, 1), make_serial(10000, 1, 1) };
+			[[maybe_unused]] size_t k = format_dates(t, out, date_format::dd_mmm_yyyy, ',');
+			assert(k == 2);
+			assert(std::string_view(out.data(), 24) == "29-Feb-2024,01-Nov-1999,");
+			k = format_dates(t, std::span(out.data(), 23), date_format::dd_mmm_yyyy, ',');
+			assert(k == 1);
+		}
+
+		return 0;
+	}
+#endif // _DEBUG
+
+} // namespace fms::date